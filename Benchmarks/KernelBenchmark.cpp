@@ -0,0 +1,133 @@
+// Throughput of the batch curve kernels against per-sample evaluation.
+//
+// Usage: Benchmarks [curves] [segLen] [repeats]
+// Samples random cubic curves every segLen the way the track sampler does
+// and reports the time of every instruction set the CPU supports.
+#include "../RollerCoaster/curves/Curve.h"
+#include "../RollerCoaster/curves/CurveKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Random cubic segments of a few units, like the curves of a long track
+static std::vector<Curve> makeCurves(int count) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+  std::vector<Curve> curves;
+  curves.reserve(count);
+  Eigen::Vector3f p(0.0f, 0.0f, 0.0f);
+  for (int i = 0; i < count; i++) {
+    Eigen::Matrix<float, 4, 3> hull;
+    hull.row(0) = p.transpose();
+    for (int j = 1; j < 4; j++) {
+      p += Eigen::Vector3f(offset(rng), 0.3f * offset(rng), offset(rng));
+      hull.row(j) = p.transpose();
+    }
+    // Bezier control points to power basis coefficients
+    Eigen::Matrix4f bezier;
+    bezier << -1, 3, -3, 1,
+               3, -6, 3, 0,
+              -3, 3, 0, 0,
+               1, 0, 0, 0;
+    curves.emplace_back(Eigen::Matrix<float, 4, 3>(bezier * hull));
+    curves.back().calculateFeatures();
+  }
+  return curves;
+}
+
+// One sampling pass: positions, tangents and curvatures of every curve
+struct Samples {
+  std::vector<float> u;
+  std::vector<Eigen::Vector3f> positions, tangents;
+  std::vector<float> curvatures;
+};
+
+static void samplePerPoint(const std::vector<Curve> &curves, float segLen, Samples &out) {
+  int offset = 0;
+  for (const Curve &c : curves) {
+    int numSeg = c.getNumSamples(segLen);
+    for (int j = 0; j < numSeg; j++) {
+      CurvePoint p = c.evaluate((float)j / (float)numSeg);
+      out.positions[offset + j] = p.position;
+      out.tangents[offset + j] = p.first;
+      out.curvatures[offset + j] = Curve::curvature(p.first, p.second);
+    }
+    offset += numSeg;
+  }
+}
+
+static void sampleBatch(const std::vector<Curve> &curves, float segLen, Samples &out) {
+  int offset = 0;
+  for (const Curve &c : curves) {
+    int numSeg = c.getNumSamples(segLen);
+    for (int j = 0; j < numSeg; j++)
+      out.u[j] = (float)j / (float)numSeg;
+    CurveKernels::evaluate(c.getMP(), out.u.data(), numSeg, out.positions.data() + offset,
+                           out.tangents.data() + offset, out.curvatures.data() + offset);
+    offset += numSeg;
+  }
+}
+
+// Best of repeats, in milliseconds
+template <typename F> static double timeBest(int repeats, F run) {
+  double best = 1e30;
+  for (int r = 0; r < repeats; r++) {
+    Clock::time_point start = Clock::now();
+    run();
+    best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+  }
+  return best;
+}
+
+// Largest position difference between two passes
+static float maxDifference(const Samples &a, const Samples &b) {
+  float d = 0.0f;
+  for (size_t i = 0; i < a.positions.size(); i++)
+    d = std::max(d, (a.positions[i] - b.positions[i]).norm());
+  return d;
+}
+
+int main(int argc, char **argv) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 2000;
+  float segLen = argc > 2 ? (float)std::atof(argv[2]) : 0.01f;
+  int repeats = argc > 3 ? std::atoi(argv[3]) : 10;
+
+  std::vector<Curve> curves = makeCurves(count);
+  int total = 0, largest = 0;
+  for (const Curve &c : curves) {
+    total += c.getNumSamples(segLen);
+    largest = std::max(largest, c.getNumSamples(segLen));
+  }
+  Samples reference, samples;
+  for (Samples *s : {&reference, &samples}) {
+    s->u.resize(largest);
+    s->positions.resize(total);
+    s->tangents.resize(total);
+    s->curvatures.resize(total);
+  }
+  std::printf("%d curves, %d samples at %g spacing, best of %d\n", count, total, segLen, repeats);
+
+  double perPoint = timeBest(repeats, [&]() { samplePerPoint(curves, segLen, reference); });
+  std::printf("  %-10s %8.2f ms\n", "per-point", perPoint);
+
+  CurveKernels::ISA best = CurveKernels::getISA();
+  double scalar = 0.0;
+  for (int i = 0; i <= (int)best; i++) {
+    CurveKernels::ISA isa = (CurveKernels::ISA)i;
+    CurveKernels::setISA(isa);
+    double ms = timeBest(repeats, [&]() { sampleBatch(curves, segLen, samples); });
+    if (isa == CurveKernels::ISA::Scalar)
+      scalar = ms;
+    std::printf("  %-10s %8.2f ms  %5.1fx per-point  %5.1fx scalar  max diff %.1e\n",
+                CurveKernels::getISAName(isa), ms, perPoint / ms, scalar / ms,
+                maxDifference(reference, samples));
+  }
+  CurveKernels::setISA(best);
+  return 0;
+}
@@ -3,6 +3,7 @@
 #include <ImGUI/imgui_impl_glfw.h>
 #include <ImGUI/imgui_impl_opengl3.h>
 #include <chrono>
+#include <cmath>
 #include <ctime>
 #include <iomanip>
 #include <memory>
@@ -20,7 +21,8 @@
 float deg2rad(float degrees) { return degrees * (M_PI / 180.0f); }
 
 Controller::Controller(int width, int height, GLFWwindow *window, Scene *scenePtr)
-    : screenWidth(width), screenHeight(height), isDragging(false), scene(scenePtr) {
+    : screenWidth(width), screenHeight(height), isDragging(false), scene(scenePtr),
+      radiusEpoch(0), tightest{-1, 0.0f, 0.0f, 0.0f} {
   // Trackball initialization
   trackball = std::make_unique<Trackball>();
   trackball->setCamera(scene->getCamera());
@@ -109,6 +111,17 @@ void Controller::render() {
         CurveProcessor::loadSpline(scene->getModel());
         scene->updateCurveRenderer();
     }
+    if (ImGui::Button("Save Binary")) {
+        CurveProcessor::saveSplineBinary(spline);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load Binary")) {
+        if (CurveProcessor::loadSplineBinary(scene->getModel()))
+            scene->updateCurveRenderer();
+    }
+    if (ImGui::Button("Export Track")) {
+        CurveProcessor::exportTrack(spline, scene->getModel()->getTrackCache());
+    }
     ImGui::Separator();
   }
 
@@ -125,12 +138,41 @@ void Controller::render() {
       if (ImGui::Checkbox("Show Curvature", &flag3)) {
           scene->setShowCurvatures(flag3);
       }
+      // Tightest turn of the track, found again only after the spline changed
+      if (spline->getEpoch() != radiusEpoch) {
+          tightest = CurveProcessor::findMaxCurvature(spline);
+          radiusEpoch = spline->getEpoch();
+      }
+      if (tightest.curve >= 0 && std::isfinite(tightest.radius))
+          ImGui::Text("Minimum Radius %.3f (curve %d, u = %.2f)", tightest.radius, tightest.curve,
+                      tightest.u);
+      else
+          ImGui::Text("Minimum Radius: straight");
+      // Tube tessellation, resampled only when a setting changes
+      TrackCache& cache = scene->getModel()->getTrackCache();
+      bool adaptive = cache.getAdaptive();
+      float chordal = cache.getChordalTolerance();
+      float angle = cache.getAngleTolerance() * 180.0f / 3.14159265f;
+      bool tessellationChanged = ImGui::Checkbox("Adaptive Tube", &adaptive);
+      if (adaptive) {
+          tessellationChanged |= ImGui::SliderFloat("Chordal Error", &chordal, 1e-5f, 1e-2f, "%.5f",
+                                                    ImGuiSliderFlags_Logarithmic);
+          tessellationChanged |= ImGui::SliderFloat("Max Turn (deg)", &angle, 0.5f, 30.0f, "%.1f");
+      }
+      if (tessellationChanged) {
+          cache.setAdaptive(adaptive);
+          cache.setTolerances(chordal, angle * 3.14159265f / 180.0f);
+          scene->updateCurveRenderer();
+      }
       ImGui::Separator();
   }
 
   bool flag_convertType = false;
   int convertType = static_cast<int>(spline->getType());
+  bool splineChanged = false;
   if (ImGui::CollapsingHeader("Spline")) {
+    // Rebuild the spline once for all edits made this frame
+    SplineEdit edit(spline);
     ImGui::Text("Curve Type");
     const char *items[] = {"Polyline", "BSpline", "Catmull-Rom" };
     if (ImGui::Combo("##CurveType", &convertType, items, IM_ARRAYSIZE(items))) {
@@ -140,7 +182,7 @@ void Controller::render() {
     bool flag0 = spline->getLoop();
     if (ImGui::Checkbox("Loop", &flag0)) {
         spline->setLoop(flag0);
-        updateSpline();
+        splineChanged = true;
     }
     bool flag1 = scene->getModel()->getUseUntiSpeed();
     if (ImGui::Checkbox("Unit Speed", &flag1)) {
@@ -154,7 +196,7 @@ void Controller::render() {
 
     if (ImGui::Button("Add Point")) {
       spline->addPoint();
-      updateSpline();
+      splineChanged = true;
     }
     
     bool active = spline->isSelectedPoint();
@@ -163,7 +205,7 @@ void Controller::render() {
         // Add Delete button at the top of the window
         if (ImGui::Button("Delete Point")) {
             spline->removePoint();
-            updateSpline();
+            splineChanged = true;
         }
         ImGui::Separator(); 
         // CONTROL POINTS
@@ -174,7 +216,7 @@ void Controller::render() {
             if (ImGui::ArrowButton("##left_x", ImGuiDir_Left)) {
                 point[0] -= 0.1f;
                 spline->setSelectedPoint(point);
-                updateSpline();
+                splineChanged = true;
             }
             ImGui::SameLine();
             char buf[32];
@@ -182,13 +224,13 @@ void Controller::render() {
             if (ImGui::InputText("##x", buf, IM_ARRAYSIZE(buf), ImGuiInputTextFlags_EnterReturnsTrue)) {
                 point[0] = std::stof(buf);
                 spline->setSelectedPoint(point);
-                updateSpline();
+                splineChanged = true;
             }
             ImGui::SameLine();
             if (ImGui::ArrowButton("##right_x", ImGuiDir_Right)) {
                 point[0] += 0.1f;
                 spline->setSelectedPoint(point);
-                updateSpline();
+                splineChanged = true;
             }
 
             // Y coordinate control
@@ -197,20 +239,20 @@ void Controller::render() {
             if (ImGui::ArrowButton("##left_y", ImGuiDir_Left)) {
                 point[1] -= 0.1f;
                 spline->setSelectedPoint(point);
-                updateSpline();
+                splineChanged = true;
             }
             ImGui::SameLine();
             sprintf(buf, "%.3f", point[1]);
             if (ImGui::InputText("##y", buf, IM_ARRAYSIZE(buf), ImGuiInputTextFlags_EnterReturnsTrue)) {
                 point[1] = std::stof(buf);
                 spline->setSelectedPoint(point);
-                updateSpline();
+                splineChanged = true;
             }
             ImGui::SameLine();
             if (ImGui::ArrowButton("##right_y", ImGuiDir_Right)) {
                 point[1] += 0.1f;
                 spline->setSelectedPoint(point);
-                updateSpline();
+                splineChanged = true;
             }
 
             // Z coordinate control
@@ -219,24 +261,26 @@ void Controller::render() {
             if (ImGui::ArrowButton("##left_z", ImGuiDir_Left)) {
                 point[2] -= 0.1f;
                 spline->setSelectedPoint(point);
-                updateSpline();
+                splineChanged = true;
             }
             ImGui::SameLine();
             sprintf(buf, "%.3f", point[2]);
             if (ImGui::InputText("##z", buf, IM_ARRAYSIZE(buf), ImGuiInputTextFlags_EnterReturnsTrue)) {
                 point[2] = std::stof(buf);
                 spline->setSelectedPoint(point);
-                updateSpline();
+                splineChanged = true;
             }
             ImGui::SameLine();
             if (ImGui::ArrowButton("##right_z", ImGuiDir_Right)) {
                 point[2] += 0.1f;
                 spline->setSelectedPoint(point);
-                updateSpline();
+                splineChanged = true;
             }
         }
     }
   }
+  if (splineChanged)
+    updateSpline();
 
   ImGui::Separator(); 
   {
@@ -297,7 +341,7 @@ void Controller::render() {
 int Controller::selectPoint(const double &x, const double &y) {
   Eigen::Vector3f pt = calculateWorldPoint(x, y, screenHeight, scene->getCamera());
   Spline *spline = scene->getModel()->getSpline();
-  std::vector<Eigen::Vector3f> &points = spline->getPoints();
+  const ControlPoints &points = spline->getPoints();
 
   float longest = VRAD * VRAD * 4.0f;
   int index = -1;
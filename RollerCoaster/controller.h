@@ -3,6 +3,7 @@
 #include "miscellaneous/camera.h"
 #include "miscellaneous/trackball.h"
 #include "scene.h"
+#include "curves/CurveProcessor.h"
 #include <GLFW/glfw3.h>
 #include <ImGUI/imgui.h>
 #include <glad/glad.h>
@@ -54,4 +55,7 @@ private:
   std::unique_ptr<Trackball> trackball;
   // window
   GLFWwindow *window;
+  // Minimum radius shown in the panel and the spline epoch it was found for
+  unsigned int radiusEpoch;
+  CurveProcessor::CurvatureExtremum tightest;
 };
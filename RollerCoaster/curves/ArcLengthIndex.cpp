@@ -0,0 +1,130 @@
+#include "ArcLengthIndex.h"
+#include "Parallel.h"
+
+static inline int lowbit(int i) { return i & -i; }
+
+void ArcLengthIndex::clear() {
+  tree.assign(1, 0.0);
+  lengths.clear();
+  sum = 0.0;
+}
+
+void ArcLengthIndex::reserve(int n) {
+  tree.reserve(n + 1);
+  lengths.reserve(n);
+}
+
+/******************************************************************************
+Append the length of the next curve
+
+Entry:
+  length - length of the curve
+
+The new node i covers (i - lowbit(i), i], its sum is the length plus the
+prefix difference of the curves already in the index
+******************************************************************************/
+void ArcLengthIndex::push_back(float length) {
+  int i = (int)lengths.size() + 1;
+  lengths.push_back(length);
+  tree.push_back(length + prefix(i - 1) - prefix(i - lowbit(i)));
+  sum += length;
+}
+
+/******************************************************************************
+Append the lengths of n curves
+
+Entry:
+  values - lengths of the curves
+  n      - number of curves
+
+Node i sums prefix(i) - prefix(i - lowbit(i)); the prefixes of the new
+curves come from one parallel scan, the ones before them from the tree
+******************************************************************************/
+void ArcLengthIndex::append(const float *values, int n) {
+  if (n <= 0)
+    return;
+  int m = size();
+  double base = sum;
+  std::vector<double> scan(n + 1);
+  Parallel::exclusiveScan(values, n, scan.data());
+
+  lengths.insert(lengths.end(), values, values + n);
+  tree.resize(m + n + 1);
+  Parallel::forRange(n, 1 << 14, [&](int begin, int end) {
+    for (int k = begin; k < end; k++) {
+      int i = m + k + 1;
+      int j = i - lowbit(i);
+      double before = (j >= m) ? base + scan[j - m] : prefix(j);
+      tree[i] = base + scan[k + 1] - before;
+    }
+  });
+  sum = base + scan[n];
+}
+
+/******************************************************************************
+Keep only the first n curves, nodes never depend on the ones after them
+******************************************************************************/
+void ArcLengthIndex::resize(int n) {
+  if (n >= size())
+    return;
+  lengths.resize(n);
+  tree.resize(n + 1);
+  sum = prefix(n);
+}
+
+/******************************************************************************
+Change the length of curve i
+
+Entry:
+  i      - index of the curve
+  length - new length of the curve
+******************************************************************************/
+void ArcLengthIndex::update(int i, float length) {
+  double delta = (double)length - (double)lengths[i];
+  lengths[i] = length;
+  for (int j = i + 1; j < (int)tree.size(); j += lowbit(j))
+    tree[j] += delta;
+  sum = prefix(size());
+}
+
+double ArcLengthIndex::prefix(int i) const {
+  double ret = 0.0;
+  for (; i > 0; i -= lowbit(i))
+    ret += tree[i];
+  return ret;
+}
+
+/******************************************************************************
+Find the curve containing arc-length s
+
+Entry:
+  s - arc-length from the start of the spline
+
+Exit:
+  rest    - s - prefix(i), left over from the descent
+  returns i with prefix(i) <= s < prefix(i + 1), descending the tree from
+  the highest power of two instead of searching the prefixes
+******************************************************************************/
+int ArcLengthIndex::find(double s, double &rest) const {
+  int n = size();
+  rest = s;
+  if (n == 0)
+    return 0;
+  int step = 1;
+  while (step * 2 <= n)
+    step *= 2;
+
+  int pos = 0;
+  for (; step > 0; step /= 2) {
+    if (pos + step <= n && tree[pos + step] <= s) {
+      pos += step;
+      s -= tree[pos];
+    }
+  }
+  if (pos == n) {
+    pos = n - 1;
+    s += lengths[pos];
+  }
+  rest = s;
+  return pos;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+// Prefix sums of curve lengths in a Fenwick (binary indexed) tree, so a
+// single curve length can change and arc-lengths can be searched in O(log n)
+class ArcLengthIndex {
+private:
+  std::vector<double> tree;     // tree[i] sums lengths (i - lowbit(i), i], 1-based
+  std::vector<float> lengths;   // Length of every curve
+  double sum;                   // Total length
+
+public:
+  ArcLengthIndex() : tree(1, 0.0), sum(0.0) {}
+
+  void clear();
+  void reserve(int n);
+  void push_back(float length);
+  // Append n lengths at once, the prefix sums are built in parallel
+  void append(const float *values, int n);
+  void resize(int n);
+  void update(int i, float length);
+
+  // Length of the first i curves
+  double prefix(int i) const;
+  // Curve i with prefix(i) <= s < prefix(i + 1), clamped to [0, size() - 1],
+  // rest is s - prefix(i)
+  int find(double s, double &rest) const;
+
+  inline int size() const { return (int)lengths.size(); }
+  inline float length(int i) const { return lengths[i]; }
+  inline double total() const { return sum; }
+};
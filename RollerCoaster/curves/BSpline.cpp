@@ -1,50 +1,51 @@
 #include "BSpline.h"
+#include "Basis.h"
 #include <algorithm>
 #include <cmath>
 
-void BSpline::build() {
-  Spline::build();
-  if (m_points.size() < 4) return;
-  /*
-  TODO: Implement the function to build the B-spline.
-  Hint:
-  1. Use addCurve to create the segments of the B-spline
-  2. If m_loop is true, create the close B-spline with m_points
-  3. Otherwise, create the open uniform B-spline with m_points
-     Note, the open uniform B-spline goes through p0 and pn
-  */
-  Eigen::Matrix4f matM;
-  matM << -1.0f, 3.0f, -3.0f, 1.0f,
-      3.0f, -6.0f, 3.0f, 0.0f,
-      -3.0f, 0.0f, 3.0f, 0.0f,
-      1.0f, 4.0f, 1.0f, 0.0f;
-  matM = matM / 6;
+// A closed B-spline has one curve per control point, the open uniform
+// B-spline repeats p0 and pn so it goes through them and has n + 1 curves
+int BSpline::segmentCount() const {
+  int n = static_cast<int>(m_points.size());
+  if (n < 4) return 0;
+  return m_loop ? n : n + 1;
+}
 
+Curve BSpline::buildSegment(int i) const {
   int n = static_cast<int>(m_points.size());
 
   if (m_loop) {
-      for (int i = 0; i < n; i++) {
-          addCurve(
-              m_points[(i - 1 + n) % n],  // P0
-              m_points[i % n],            // P1
-              m_points[(i + 1) % n],      // P2
-              m_points[(i + 2) % n],      // P3
-              matM);
-      }
+      return Curve(computeCoefficients<BSplineBasis>(
+          m_points[(i - 1 + n) % n],  // P0
+          m_points[i % n],            // P1
+          m_points[(i + 1) % n],      // P2
+          m_points[(i + 2) % n]));    // P3
   }
-  else {
-      // Open Uniform B-Spline (ensuring start at P0 and end at Pn)
-      addCurve(m_points[0], m_points[0], m_points[0], m_points[1], matM);
-      addCurve(m_points[0], m_points[0], m_points[1], m_points[2], matM); 
-      for (int i = 0; i < n - 3; i++) {
-          addCurve(
-              m_points[i],     // P0
-              m_points[i + 1], // P1
-              m_points[i + 2], // P2
-              m_points[i + 3], // P3
-              matM);
-      }
-      addCurve(m_points[n - 3], m_points[n - 2], m_points[n - 1], m_points[n - 1], matM); 
-      addCurve(m_points[n - 2], m_points[n - 1], m_points[n - 1], m_points[n - 1], matM);
+
+  // Open Uniform B-Spline (ensuring start at P0 and end at Pn)
+  if (i == 0)
+      return Curve(computeCoefficients<BSplineBasis>(m_points[0], m_points[0], m_points[0], m_points[1]));
+  if (i == 1)
+      return Curve(computeCoefficients<BSplineBasis>(m_points[0], m_points[0], m_points[1], m_points[2]));
+  if (i == n - 1)
+      return Curve(computeCoefficients<BSplineBasis>(m_points[n - 3], m_points[n - 2], m_points[n - 1], m_points[n - 1]));
+  if (i == n)
+      return Curve(computeCoefficients<BSplineBasis>(m_points[n - 2], m_points[n - 1], m_points[n - 1], m_points[n - 1]));
+  return Curve(computeCoefficients<BSplineBasis>(
+      m_points[i - 2],  // P0
+      m_points[i - 1],  // P1
+      m_points[i],      // P2
+      m_points[i + 1])); // P3
+}
+
+// Curve i blends p(i-2) .. p(i+1), so p(k) shapes curves k - 1 .. k + 2
+void BSpline::affectedSegments(int k, int& first, int& count) const {
+  int n = static_cast<int>(m_points.size());
+  if (m_loop) {
+      first = ((k - 2) % n + n) % n;
+      count = std::min(4, n);
+      return;
   }
-}
\ No newline at end of file
+  first = std::max(k - 1, 0);
+  count = std::min(k + 2, n) - first + 1;
+}
@@ -5,7 +5,9 @@
 class BSpline : public Spline
 {
 protected:
-  void build() override;
+  int segmentCount() const override;
+  Curve buildSegment(int i) const override;
+  void affectedSegments(int k, int& first, int& count) const override;
 public:
   BSpline() : Spline(Type::BSpline) {}
 };
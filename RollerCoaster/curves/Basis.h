@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+// Constant basis matrices M of C(u) = [u^3 u^2 u 1] * M * P
+struct BSplineBasis {
+  static constexpr float M[4][4] = {
+    { -1.0f / 6.0f,  3.0f / 6.0f, -3.0f / 6.0f, 1.0f / 6.0f },
+    {  3.0f / 6.0f, -6.0f / 6.0f,  3.0f / 6.0f, 0.0f },
+    { -3.0f / 6.0f,  0.0f,         3.0f / 6.0f, 0.0f },
+    {  1.0f / 6.0f,  4.0f / 6.0f,  1.0f / 6.0f, 0.0f } };
+};
+
+struct CatmullRomBasis {
+  static constexpr float M[4][4] = {
+    { -0.5f,  1.5f, -1.5f,  0.5f },
+    {  1.0f, -2.5f,  2.0f, -0.5f },
+    { -0.5f,  0.0f,  0.5f,  0.0f },
+    {  0.0f,  1.0f,  0.0f,  0.0f } };
+};
+
+// First segment of an open Catmull-Rom spline, through p0 with p0, p1, p2
+struct CatmullRomFirstBasis {
+  static constexpr float M[4][4] = {
+    {  1.5f, -1.0f,  0.5f, 0.0f },
+    { -1.5f,  1.0f, -0.5f, 0.0f },
+    { -1.0f,  1.0f,  0.0f, 0.0f },
+    {  1.0f,  0.0f,  0.0f, 0.0f } };
+};
+
+// Last segment of an open Catmull-Rom spline, through pn with pn-2, pn-1, pn
+struct CatmullRomLastBasis {
+  static constexpr float M[4][4] = {
+    { -0.5f,  2.0f, -0.5f, 0.0f },
+    {  0.0f, -3.0f,  1.0f, 0.0f },
+    {  0.5f,  0.0f,  0.5f, 0.0f },
+    {  0.0f,  1.0f,  0.0f, 0.0f } };
+};
+
+// sum += M[r][k] * p, dropped at compile time where the entry is zero
+template <class Basis, int r, int k>
+inline void addBasisTerm(Eigen::Vector3f &sum, const Eigen::Vector3f &p) {
+  if constexpr (Basis::M[r][k] != 0.0f)
+    sum += Basis::M[r][k] * p;
+}
+
+// Row r of M * P
+template <class Basis, int r>
+inline Eigen::Vector3f basisRow(const Eigen::Vector3f &p0, const Eigen::Vector3f &p1,
+                                const Eigen::Vector3f &p2, const Eigen::Vector3f &p3) {
+  Eigen::Vector3f sum = Eigen::Vector3f::Zero();
+  addBasisTerm<Basis, r, 0>(sum, p0);
+  addBasisTerm<Basis, r, 1>(sum, p1);
+  addBasisTerm<Basis, r, 2>(sum, p2);
+  addBasisTerm<Basis, r, 3>(sum, p3);
+  return sum;
+}
+
+// M * P with M a compile-time constant, unrolled into scaled sums of the
+// points with the zero entries of M left out; no 4x4 matrix is built
+template <class Basis>
+inline Eigen::Matrix<float, 4, 3> computeCoefficients(const Eigen::Vector3f &p0,
+                                                      const Eigen::Vector3f &p1,
+                                                      const Eigen::Vector3f &p2,
+                                                      const Eigen::Vector3f &p3) {
+  Eigen::Matrix<float, 4, 3> C;
+  C.row(0) = basisRow<Basis, 0>(p0, p1, p2, p3).transpose();
+  C.row(1) = basisRow<Basis, 1>(p0, p1, p2, p3).transpose();
+  C.row(2) = basisRow<Basis, 2>(p0, p1, p2, p3).transpose();
+  C.row(3) = basisRow<Basis, 3>(p0, p1, p2, p3).transpose();
+  return C;
+}
@@ -11,15 +11,16 @@ Cart::Cart(float offset)
 
 Cart::~Cart() {}
 
-void Cart::update(Spline *spline, float t, bool useUnitSpeed, bool useBishop) {
+void Cart::update(const SplineSnapshot &snapshot, float t, bool useUnitSpeed, bool useBishop) {
   float u = t - m_Offset;
   if (u < 0.0f) {
     u = 0.0f;
   }
   Eigen::Vector3f t0 = m_Tangent;
   Eigen::Vector3f n0 = m_Normal;
-  m_Posn = spline->getPosition(u, useUnitSpeed);
-  m_Tangent = spline->getTangent(u, useUnitSpeed);
+  CurvePoint p = m_Cursor.evaluate(snapshot, u, useUnitSpeed);
+  m_Posn = p.position;
+  m_Tangent = p.first;
   m_Tangent.normalize();
   if (useBishop && m_Normal.squaredNorm() > 0.1f) {
     m_Normal = CurveProcessor::parallelTransport(n0, t0, m_Tangent);
@@ -3,6 +3,7 @@
 #include <Eigen/Dense>
 #include <vector>
 #include "Spline.h"
+#include "SplineCursor.h"
 
 class Cart
 {
@@ -11,6 +12,7 @@ private:
 	Eigen::Vector3f m_Posn;
 	Eigen::Vector3f m_Tangent;
 	Eigen::Vector3f m_Normal;
+	SplineCursor m_Cursor;
 
 public:
 
@@ -18,7 +20,8 @@ public:
 	Cart(float offset);
 	~Cart();
 
-	void update(Spline* spline, float t, bool useUnitSpeed, bool useBishop);
+	// Move along the last committed state of the spline
+	void update(const SplineSnapshot& snapshot, float t, bool useUnitSpeed, bool useBishop);
 
 	Eigen::Vector3f& resetNormal();
 	const Eigen::Vector3f& getPosition() const { return m_Posn; }
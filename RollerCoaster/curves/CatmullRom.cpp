@@ -1,76 +1,51 @@
 #include "CatmullRom.h"
+#include "Basis.h"
 #include <algorithm>
 #include <cmath>
 
-void CatmullRom::build() {
-    Spline::build();
-    if (m_points.size() < 4) return;
-    /*
-      TODO: Implement the function to build the Catmull-Rom spline.
-      Hint:
-      1. Use addCurve to create the segments of the B-spline
-      2. If m_loop is true, create the close Catmull-Rom spline with m_points
-      3. Otherwise, create the open Catmull-Rom spline with m_points
-         Note, the open Catmull-Rom spline goes through p0 and pn
-    */
-    Eigen::Matrix4f matM, matMF, matML;
-    matM << -0.5f, 1.5f, -1.5f, 0.5f,
-        1.0f, -2.5f, 2.0f, -0.5f,
-        -0.5f, 0.0f, 0.5f, 0.0f,
-        0.0f, 1.0f, 0.0f, 0.0f;
-
-    matMF << 1.5f, -1.0f, 0.5f, 0.0f,
-        -1.5f, 1.0f, -0.5f, 0.0f,
-        -1.0f, 1.0f, 0.0f, 0.0f,
-        1.0f, 0.0f, 0.0f, 0.0f;
+// A closed Catmull-Rom spline has one curve per control point, the open one
+// goes through p0 and pn with special first and last curves, n - 1 in total
+int CatmullRom::segmentCount() const {
+    int n = static_cast<int>(m_points.size());
+    if (n < 4) return 0;
+    return m_loop ? n : n - 1;
+}
 
-    matML << -0.5f, 2.0f, -0.5f, 0.0f,
-        0.0f, -3.0f, 1.0f, 0.0f,
-        0.5f, 0.0f, 0.5f, 0.0f,
-        0.0f, 1.0f, 0.0f, 0.0f;
+Curve CatmullRom::buildSegment(int i) const {
     int n = static_cast<int>(m_points.size());
 
     if (m_loop) {
         // Closed Catmull-Rom Spline (Looping)
-        for (int i = 0; i < n; i++) {
-            addCurve(
-                m_points[(i - 1 + n) % n],  // P0
-                m_points[i % n],            // P1
-                m_points[(i + 1) % n],      // P2
-                m_points[(i + 2) % n],      // P3
-                matM);
-        }
+        return Curve(computeCoefficients<CatmullRomBasis>(
+            m_points[(i - 1 + n) % n],  // P0
+            m_points[i % n],            // P1
+            m_points[(i + 1) % n],      // P2
+            m_points[(i + 2) % n]));    // P3
     }
-    else if (n > 3) {
-        // Open Catmull-Rom Spline
-
-        // First segment
-        addCurve(
-            m_points[0],
-            m_points[1],
-            m_points[2],
-            Eigen::Vector3f::Zero(), 
-            matMF
-        );
-
-        for (int i = 0; i < n - 3; i++) {
-            addCurve(
-                m_points[i],
-                m_points[i + 1],
-                m_points[i + 2],
-                m_points[i + 3],
-                matM
-            );
-        }
 
-        // Last segment
-        addCurve(
-            m_points[n - 3],
-            m_points[n - 2],
-            m_points[n - 1],  
-            Eigen::Vector3f::Zero(),  
-            matML
-        );
+    // First segment
+    if (i == 0)
+        return Curve(computeCoefficients<CatmullRomFirstBasis>(
+            m_points[0], m_points[1], m_points[2], Eigen::Vector3f::Zero()));
+    // Last segment
+    if (i == n - 2)
+        return Curve(computeCoefficients<CatmullRomLastBasis>(
+            m_points[n - 3], m_points[n - 2], m_points[n - 1], Eigen::Vector3f::Zero()));
+    return Curve(computeCoefficients<CatmullRomBasis>(
+        m_points[i - 1],
+        m_points[i],
+        m_points[i + 1],
+        m_points[i + 2]));
+}
+
+// Curve i blends p(i-1) .. p(i+2), so p(k) shapes curves k - 2 .. k + 1
+void CatmullRom::affectedSegments(int k, int& first, int& count) const {
+    int n = static_cast<int>(m_points.size());
+    if (m_loop) {
+        first = ((k - 2) % n + n) % n;
+        count = std::min(4, n);
+        return;
     }
-
-}
\ No newline at end of file
+    first = std::max(k - 2, 0);
+    count = std::min(k + 1, n - 2) - first + 1;
+}
@@ -5,7 +5,9 @@
 class CatmullRom : public Spline
 {
 protected:
-  void build() override;
+  int segmentCount() const override;
+  Curve buildSegment(int i) const override;
+  void affectedSegments(int k, int& first, int& count) const override;
 public:
   CatmullRom() : Spline(Type::CatmullRom) {}
 };
@@ -0,0 +1,219 @@
+#include "ControlPoints.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file, unmapped with the last ControlPoints using it
+struct ControlPoints::MappedFile
+{
+  const char* data = nullptr;
+  size_t size = 0;
+  std::string path;
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE mapping = nullptr;
+#endif
+
+  ~MappedFile();
+  bool open(const std::string& path);
+};
+
+ControlPoints::MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+  if (data) UnmapViewOfFile(data);
+  if (mapping) CloseHandle(mapping);
+  if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+  if (data) munmap((void*)data, size);
+#endif
+}
+
+bool ControlPoints::MappedFile::open(const std::string& path)
+{
+  this->path = path;
+#ifdef _WIN32
+  file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                     FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER bytes;
+  if (!GetFileSizeEx(file, &bytes) || bytes.QuadPart == 0) return false;
+  size = (size_t)bytes.QuadPart;
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) return false;
+  data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  return data != nullptr;
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  size = (size_t)info.st_size;
+  void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) return false;
+  data = (const char*)view;
+  return true;
+#endif
+}
+
+ControlPoints::ControlPoints()
+  : owned(std::make_shared<std::vector<Eigen::Vector3f>>()), points(nullptr), count(0) {}
+
+ControlPoints::ControlPoints(const std::vector<Eigen::Vector3f>& values)
+  : owned(std::make_shared<std::vector<Eigen::Vector3f>>(values)),
+    points(owned->data()), count((int)values.size()) {}
+
+ControlPoints::ControlPoints(std::vector<Eigen::Vector3f>&& values)
+  : owned(std::make_shared<std::vector<Eigen::Vector3f>>(std::move(values))),
+    points(owned->data()), count((int)owned->size()) {}
+
+/******************************************************************************
+Map control points from a file instead of reading them
+
+Entry:
+  path   - file holding x, y, z floats per point
+  offset - bytes before the first point, a multiple of 4
+  count  - number of points, < 0 for all points up to the end of the file
+
+Exit:
+  returns false if the file cannot be mapped or is too short, the points
+  are unchanged then; pages are only read when the points are accessed
+******************************************************************************/
+bool ControlPoints::map(const std::string& path, size_t offset, int count)
+{
+  std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+  if (!file->open(path) || offset > file->size || offset % sizeof(float) != 0)
+    return false;
+  size_t available = (file->size - offset) / sizeof(Eigen::Vector3f);
+  if (count < 0)
+    count = (int)available;
+  if ((size_t)count > available)
+    return false;
+
+  owned.reset();
+  mapped = file;
+  points = reinterpret_cast<const Eigen::Vector3f*>(file->data + offset);
+  this->count = count;
+  return true;
+}
+
+bool ControlPoints::write(std::ostream& out) const
+{
+  out.write(reinterpret_cast<const char*>(points), (std::streamsize)count * sizeof(Eigen::Vector3f));
+  return (bool)out;
+}
+
+/******************************************************************************
+Save the points behind a header
+
+Entry:
+  path       - the file to write
+  header     - bytes written before the points
+  headerSize - number of header bytes
+
+Exit:
+  returns false if the file cannot be written, path is unchanged then
+
+The file is written under a temporary name first and renamed over path, so
+it is never truncated while points are mapped from it. POSIX keeps the old
+file alive for its mappings; Windows refuses to replace a mapped file, so
+points mapped from path have to be unmapped before
+******************************************************************************/
+bool ControlPoints::save(const std::string& path, const void* header, size_t headerSize) const
+{
+  std::string temporary = path + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary);
+    if (!out || !out.write(reinterpret_cast<const char*>(header), (std::streamsize)headerSize) ||
+        !write(out)) {
+      out.close();
+      std::remove(temporary.c_str());
+      return false;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+void ControlPoints::unmap()
+{
+  if (mapped)
+    detach();
+}
+
+bool ControlPoints::isMappedFrom(const std::string& path) const
+{
+  std::error_code error;
+  return mapped && std::filesystem::equivalent(mapped->path, path, error);
+}
+
+/******************************************************************************
+Make the storage owned by this object alone before a change, copying it if
+it is mapped or shared with another copy
+******************************************************************************/
+std::vector<Eigen::Vector3f>& ControlPoints::detach()
+{
+  if (!owned || owned.use_count() > 1) {
+    owned = std::make_shared<std::vector<Eigen::Vector3f>>(points, points + count);
+    mapped.reset();
+  }
+  return *owned;
+}
+
+void ControlPoints::set(int i, const Eigen::Vector3f& p)
+{
+  std::vector<Eigen::Vector3f>& v = detach();
+  v[i] = p;
+  points = v.data();
+}
+
+void ControlPoints::push_back(const Eigen::Vector3f& p)
+{
+  std::vector<Eigen::Vector3f>& v = detach();
+  v.push_back(p);
+  points = v.data();
+  count = (int)v.size();
+}
+
+void ControlPoints::insert(int i, const Eigen::Vector3f& p)
+{
+  std::vector<Eigen::Vector3f>& v = detach();
+  v.insert(v.begin() + i, p);
+  points = v.data();
+  count = (int)v.size();
+}
+
+void ControlPoints::erase(int i)
+{
+  std::vector<Eigen::Vector3f>& v = detach();
+  v.erase(v.begin() + i);
+  points = v.data();
+  count = (int)v.size();
+}
+
+void ControlPoints::clear()
+{
+  *this = ControlPoints();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Control points of a spline. Copies share one storage, either an owned
+// array or a read-only memory-mapped file; the first change to a shared or
+// mapped storage copies it (copy on write).
+class ControlPoints
+{
+private:
+  struct MappedFile;
+
+  std::shared_ptr<std::vector<Eigen::Vector3f>> owned;
+  std::shared_ptr<const MappedFile> mapped;
+  const Eigen::Vector3f* points;
+  int count;
+
+  std::vector<Eigen::Vector3f>& detach();
+
+public:
+  ControlPoints();
+  ControlPoints(const std::vector<Eigen::Vector3f>& values);
+  ControlPoints(std::vector<Eigen::Vector3f>&& values);
+
+  // Map count points at offset bytes into a file of raw x, y, z floats,
+  // count < 0 takes the rest of the file; returns false if it cannot be mapped
+  bool map(const std::string& path, size_t offset, int count = -1);
+  // Write the points as raw x, y, z floats
+  bool write(std::ostream& out) const;
+  // Write headerSize bytes of header and the points to a temporary file and
+  // rename it to path, so mappings of the old file stay valid on POSIX
+  bool save(const std::string& path, const void* header, size_t headerSize) const;
+  // Copy mapped points into memory, so their file can be replaced
+  void unmap();
+  // True if the points are mapped from the file at path
+  bool isMappedFrom(const std::string& path) const;
+
+  void set(int i, const Eigen::Vector3f& p);
+  void push_back(const Eigen::Vector3f& p);
+  void insert(int i, const Eigen::Vector3f& p);
+  void erase(int i);
+  void clear();
+
+  inline int size() const { return count; }
+  inline bool empty() const { return count == 0; }
+  inline const Eigen::Vector3f& operator[](int i) const { return points[i]; }
+  inline const Eigen::Vector3f& back() const { return points[count - 1]; }
+  inline const Eigen::Vector3f* data() const { return points; }
+  inline const Eigen::Vector3f* begin() const { return points; }
+  inline const Eigen::Vector3f* end() const { return points + count; }
+  inline bool isMapped() const { return mapped != nullptr; }
+};
@@ -1,4 +1,7 @@
 #include "Curve.h"
+#include "CurveKernels.h"
+#include "Polynomial.h"
+#include <algorithm>
 #include <iostream>
 #include <Eigen/Dense>
 
@@ -13,89 +16,661 @@ Curve::Curve(const Eigen::Vector3f& a, const Eigen::Vector3f& b,
     c.transpose(),
     d.transpose();
   mMP = M * P;
+  initialize();
 }
 
-// Calculate C(u) = T * M * P
-Eigen::Vector3f Curve::getPosition(float u) {
-  Eigen::Matrix<float, 1, 4> matU;
-  matU << u * u * u, u * u, u, 1.0f;
-  Eigen::Vector3f ret = (matU * mMP).transpose();
-  return ret;
+// Straight line from a to b, C(u) = (b - a) * u + a
+Curve::Curve(const Eigen::Vector3f& a, const Eigen::Vector3f& b) : length(0) {
+  mMP.topRows<2>().setZero();
+  mMP.row(2) = (b - a).transpose();
+  mMP.row(3) = a.transpose();
+  initialize();
+}
+
+Curve::Curve() : Curve(Eigen::Matrix<float, 4, 3>::Zero()) {}
+
+// Curve from precomputed M * P coefficients
+Curve::Curve(const Eigen::Matrix<float, 4, 3>& mp) : mMP(mp), length(0) {
+  initialize();
+}
+
+// Degree of the stored polynomial
+void Curve::initialize() {
+  if (!mMP.row(0).isZero(0.0f))
+    mDegree = 3;
+  else if (!mMP.row(1).isZero(0.0f))
+    mDegree = 2;
+  else
+    mDegree = 1;
+}
+
+// Bezier control points from the power basis, rows B0..B3
+Eigen::Matrix<float, 4, 3> Curve::getHull() const {
+  const Eigen::RowVector3f a = mMP.row(0), b = mMP.row(1), c = mMP.row(2), d = mMP.row(3);
+  Eigen::Matrix<float, 4, 3> hull;
+  hull.row(0) = d;
+  hull.row(1) = d + c / 3.0f;
+  hull.row(2) = d + 2.0f * c / 3.0f + b / 3.0f;
+  hull.row(3) = a + b + c + d;
+  return hull;
+}
+
+// Tight axis-aligned bounds of C([0, 1])
+Eigen::AlignedBox3f Curve::getBounds() const {
+  const Eigen::RowVector3f a = mMP.row(0), b = mMP.row(1), c = mMP.row(2), d = mMP.row(3);
+  Eigen::AlignedBox3f bounds;
+  bounds.extend(d.transpose());
+  bounds.extend((a + b + c + d).transpose());
+
+  // The extremes per axis are at the ends or where C'(u) = 3a u^2 + 2b u + c is zero
+  for (int k = 0; k < 3 && mDegree > 1; k++) {
+    float qa = 3.0f * a[k], qb = 2.0f * b[k], qc = c[k];
+    float roots[2];
+    int n = 0;
+    if (std::abs(qa) < 1e-12f) {
+      if (std::abs(qb) > 1e-12f) roots[n++] = -qc / qb;
+    } else {
+      float disc = qb * qb - 4.0f * qa * qc;
+      if (disc >= 0.0f) {
+        // Avoid cancellation in the smaller root
+        float q = -0.5f * (qb + std::copysign(std::sqrt(disc), qb));
+        roots[n++] = q / qa;
+        if (q != 0.0f) roots[n++] = qc / q;
+      }
+    }
+    for (int i = 0; i < n; i++) {
+      if (roots[i] > 0.0f && roots[i] < 1.0f)
+        bounds.extend(getPosition(roots[i]));
+    }
+  }
+  // Pad by the rounding error of evaluating C(u) so the box stays conservative
+  float pad = 1e-6f * (1.0f + bounds.min().cwiseAbs().cwiseMax(bounds.max().cwiseAbs()).maxCoeff());
+  bounds.min().array() -= pad;
+  bounds.max().array() += pad;
+  return bounds;
+}
+
+// Axis-aligned bounds of the control hull, looser than getBounds but cheaper
+// to refresh after subdivision
+Eigen::AlignedBox3f Curve::getHullBounds() const {
+  const Eigen::Matrix<float, 4, 3> hull = getHull();
+  return Eigen::AlignedBox3f(hull.colwise().minCoeff().transpose(),
+                             hull.colwise().maxCoeff().transpose());
 }
 
-// Calculate the unit tangent vector at u
-Eigen::Vector3f Curve::getTangent(float u) {
-  Eigen::Matrix<float, 1, 4> matU;
-  matU << 3.0f * u * u, 2.0f * u, 1.0f, 0.0f;
-  Eigen::Vector3f ret = (matU * mMP).transpose();
+// Largest distance of the inner control points from the chord B0 B3,
+// the curve is within this distance of the straight segment
+float Curve::getFlatness() const {
+  const Eigen::Matrix<float, 4, 3> hull = getHull();
+  const Eigen::Vector3f b0 = hull.row(0).transpose(), b3 = hull.row(3).transpose();
+  const Eigen::Vector3f chord = b3 - b0;
+  float len2 = chord.squaredNorm();
+  float ret = 0.0f;
+  for (int i = 1; i <= 2; i++) {
+    Eigen::Vector3f v = hull.row(i).transpose() - b0;
+    float dist = (len2 > 0.0f) ? v.cross(chord).norm() / std::sqrt(len2) : v.norm();
+    ret = std::max(ret, dist);
+  }
   return ret;
 }
 
-/*
-  TODO: Implement the function to compute the curvature.
-*/
-float Curve::getCurvature(float u)
-{
-    // Compute first derivative (tangent)
-    Eigen::Vector3f alpha_prime = getTangent(u);
+// Split the curve at t with de Casteljau, left and right are the control
+// hulls of [0, t] and [t, 1] reparameterized to [0, 1]
+void Curve::subdivide(float t, Eigen::Matrix<float, 4, 3>& left,
+                      Eigen::Matrix<float, 4, 3>& right) const {
+  subdivide(getHull(), t, left, right);
+}
 
-    // Compute second derivative using central difference
-    float h = 1e-4f;  // Small step for finite differences
-    Eigen::Vector3f alpha_prime1 = getTangent(u + h);
-    Eigen::Vector3f alpha_prime2 = getTangent(u - h);
-    Eigen::Vector3f alpha_double_prime = (alpha_prime1 - alpha_prime2) / (2 * h);
+void Curve::subdivide(const Eigen::Matrix<float, 4, 3>& hull, float t,
+                      Eigen::Matrix<float, 4, 3>& left, Eigen::Matrix<float, 4, 3>& right) {
+  const Eigen::RowVector3f p01 = hull.row(0) + t * (hull.row(1) - hull.row(0));
+  const Eigen::RowVector3f p12 = hull.row(1) + t * (hull.row(2) - hull.row(1));
+  const Eigen::RowVector3f p23 = hull.row(2) + t * (hull.row(3) - hull.row(2));
+  const Eigen::RowVector3f p012 = p01 + t * (p12 - p01);
+  const Eigen::RowVector3f p123 = p12 + t * (p23 - p12);
+  const Eigen::RowVector3f p0123 = p012 + t * (p123 - p012);
+  left << hull.row(0), p01, p012, p0123;
+  right << p0123, p123, p23, hull.row(3);
+}
 
-    // Compute cross product || \'(u)  \''(u) ||
-    Eigen::Vector3f cross_product = alpha_prime.cross(alpha_double_prime);
-    float numerator = cross_product.norm();
+// Calculate the curvature k = ||C' x C''|| / ||C'||^3 at u
+float Curve::getCurvature(float u) const
+{
+    if (mDegree == 1) return 0.0f;
+    CurvePoint p = evaluate(u);
+    return curvature(p.first, p.second);
+}
 
-    // Compute || \'(u) ||^3
-    float denominator = std::pow(alpha_prime.norm(), 3);
+// Curvature from the first and second derivative
+float Curve::curvature(const Eigen::Vector3f& first, const Eigen::Vector3f& second)
+{
+    float speed2 = first.squaredNorm();
+    float denominator = speed2 * std::sqrt(speed2);
 
     // Avoid division by zero
     if (denominator < 1e-6f) return 0.0f;
 
-    return numerator / denominator;
+    return first.cross(second).norm() / denominator;
+}
+
+// Maximum curvature over u in [0, 1] and the u where it is reached
+//
+// With W = C' x C'', N = ||W||^2 and D = ||C'||^2 both have degree 4 and
+// k^2 = N / D^3, so the interior extrema are the roots of N' D - 3 N D'
+float Curve::getMaxCurvature(float& u) const
+{
+    u = 0.0f;
+    if (mDegree == 1) return 0.0f;
+
+    const Eigen::Matrix<double, 4, 3> mp = mMP.cast<double>();
+    const Eigen::Vector3d a = mp.row(0).transpose();
+    const Eigen::Vector3d b = mp.row(1).transpose();
+    const Eigen::Vector3d c = mp.row(2).transpose();
+    // C' = 3a u^2 + 2b u + c, W = -6 (a x b) u^2 + 6 (c x a) u + 2 (c x b)
+    const Eigen::Vector3d v[3] = { c, 2.0 * b, 3.0 * a };
+    const Eigen::Vector3d w[3] = { 2.0 * c.cross(b), 6.0 * c.cross(a), -6.0 * a.cross(b) };
+    double N[5] = { 0.0 }, D[5] = { 0.0 };
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            N[i + j] += w[i].dot(w[j]);
+            D[i + j] += v[i].dot(v[j]);
+        }
+    }
+
+    double dN[4], dD[4], P[8] = { 0.0 };
+    Polynomial::derivative(N, 4, dN);
+    Polynomial::derivative(D, 4, dD);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j <= 4; j++)
+            P[i + j] += dN[i] * D[j] - 3.0 * N[j] * dD[i];
+    }
+
+    double candidates[Polynomial::MAX_DEGREE + 2];
+    int n = Polynomial::roots(P, 7, 0.0, 1.0, candidates);
+    candidates[n++] = 0.0;
+    candidates[n++] = 1.0;
+
+    double best = 0.0;
+    for (int k = 0; k < n; k++) {
+        double speed2 = Polynomial::evaluate(D, 4, candidates[k]);
+        double denominator = speed2 * std::sqrt(std::max(speed2, 0.0));
+        // Same cut-off as curvature() for a vanishing tangent
+        if (denominator < 1e-6) continue;
+        double k2 = std::max(Polynomial::evaluate(N, 4, candidates[k]), 0.0);
+        double kappa = std::sqrt(k2) / denominator;
+        if (kappa > best) {
+            best = kappa;
+            u = (float)candidates[k];
+        }
+    }
+    return (float)best;
+}
+
+// Frenet frame, curvature and torsion at u
+FrenetFrame Curve::getFrenetFrame(float u) const
+{
+    FrenetFrame ret;
+    getFrenetFrames(&u, 1, &ret);
+    return ret;
+}
+
+// Batch version of getFrenetFrame. C''' = 6a is constant over the curve, so
+// torsion costs one dot product per parameter. Where C' and C'' are parallel
+// the normal falls back to the same up-vector heuristic as the track normals
+void Curve::getFrenetFrames(const float* u, int n, FrenetFrame* frames) const
+{
+    const Eigen::Vector3f a = mMP.row(0).transpose();
+    const Eigen::Vector3f b = mMP.row(1).transpose();
+    const Eigen::Vector3f c = mMP.row(2).transpose();
+    const Eigen::Vector3f third = 6.0f * a;
+    for (int i = 0; i < n; i++) {
+        FrenetFrame& f = frames[i];
+        Eigen::Vector3f first = (3.0f * a * u[i] + 2.0f * b) * u[i] + c;
+        Eigen::Vector3f second = third * u[i] + 2.0f * b;
+        Eigen::Vector3f w = first.cross(second);
+        float speed2 = first.squaredNorm();
+        float w2 = w.squaredNorm();
+        f.tangent = first.normalized();
+        if (w2 > 1e-12f * speed2 * speed2) {
+            float wNorm = std::sqrt(w2);
+            f.binormal = w / wNorm;
+            f.normal = f.binormal.cross(f.tangent);
+            f.curvature = wNorm / (speed2 * std::sqrt(speed2));
+            f.torsion = w.dot(third) / w2;
+        } else {
+            Eigen::Vector3f up = Eigen::Vector3f(0.0f, 1.0f, 0.0f);
+            if (std::abs(f.tangent.dot(up)) > 0.99f)
+                up = Eigen::Vector3f(1.0f, 0.0f, 0.0f);
+            f.normal = f.tangent.cross(up).normalized();
+            f.binormal = f.tangent.cross(f.normal);
+            f.curvature = 0.0f;
+            f.torsion = 0.0f;
+        }
+    }
+}
+
+// Batch version of evaluate, any output may be null
+void Curve::evaluate(const float* u, int n, Eigen::Vector3f* positions,
+                     Eigen::Vector3f* tangents, float* curvatures) const
+{
+    if (mDegree > 1) {
+        CurveKernels::evaluate(mMP, u, n, positions, tangents, curvatures);
+        return;
+    }
+    // Lines have a constant tangent and no curvature
+    const Eigen::Vector3f c = mMP.row(2).transpose();
+    const Eigen::Vector3f d = mMP.row(3).transpose();
+    for (int i = 0; i < n; i++) {
+        if (positions) positions[i] = c * u[i] + d;
+        if (tangents) tangents[i] = c;
+        if (curvatures) curvatures[i] = 0.0f;
+    }
+}
+
+namespace {
+
+// 5-point Gauss-Legendre nodes and weights on [-1, 1]
+const float glNodes[5] = { -0.9061798459386640f, -0.5384693101056831f, 0.0f,
+                            0.5384693101056831f, 0.9061798459386640f };
+const float glWeights[5] = { 0.2369268850561891f, 0.4786286704993665f, 0.5688888888888889f,
+                             0.4786286704993665f, 0.2369268850561891f };
+const int maxDepth = 12;
+// Pieces are at most 2^-tableDepth wide when the quadrature fills a table
+const int tableDepth = 2;
+
+// Integrate ||C'(u)|| over [a, b], keeping the speed at the nodes when asked
+float integrateSpeed(const Curve& curve, float a, float b, int& evaluations,
+                     float* speeds = nullptr)
+{
+    float half = 0.5f * (b - a), mid = 0.5f * (a + b);
+    float sum = 0.0f;
+    for (int i = 0; i < 5; i++) {
+        float speed = curve.getTangent(mid + half * glNodes[i]).norm();
+        if (speeds) speeds[i] = speed;
+        sum += glWeights[i] * speed;
+    }
+    evaluations += 5;
+    return sum * half;
+}
+
+// Lagrange polynomials through the nodes and their integrals from -1 to x,
+// coefficients of the powers of x
+struct LagrangeBasis
+{
+    double value[5][5];
+    double integral[5][6];
+
+    LagrangeBasis() {
+        for (int i = 0; i < 5; i++) {
+            double* l = value[i];
+            l[0] = 1.0;
+            for (int d = 1; d < 5; d++) l[d] = 0.0;
+            for (int j = 0, degree = 0; j < 5; j++) {
+                if (j == i) continue;
+                double scale = 1.0 / ((double)glNodes[i] - glNodes[j]);
+                for (int d = ++degree; d >= 0; d--)
+                    l[d] = ((d > 0 ? l[d - 1] : 0.0) - glNodes[j] * l[d]) * scale;
+            }
+            double atStart = 0.0;
+            for (int d = 0; d < 5; d++) {
+                integral[i][d + 1] = l[d] / (d + 1);
+                atStart += (d % 2 ? 1.0 : -1.0) * integral[i][d + 1];
+            }
+            integral[i][0] = -atStart;
+        }
+    }
+};
+
+const LagrangeBasis& lagrangeBasis()
+{
+    static const LagrangeBasis basis;
+    return basis;
+}
+
+// Knots k of the table with a < k / SIZE < b
+void innerKnots(float a, float b, int& first, int& last)
+{
+    const int N = ArcLengthTable::SIZE;
+    first = (int)std::floor(a * N) + 1;
+    last = (int)std::ceil(b * N) - 1;
+}
+
+// Whether the polynomial through the speeds at the nodes of [a, b] matches
+// the speed the table holds at the knots inside, close enough for the
+// arc-length of the knots to be within tolerance
+bool followsKnots(const ArcLengthTable& table, float a, float b, const float* speeds,
+                  float tolerance)
+{
+    int first, last;
+    innerKnots(a, b, first, last);
+    if (first > last) return true;
+
+    const LagrangeBasis& basis = lagrangeBasis();
+    double poly[5] = {};
+    for (int i = 0; i < 5; i++)
+        for (int d = 0; d < 5; d++)
+            poly[d] += speeds[i] * basis.value[i][d];
+    double half = 0.5 * ((double)b - a), mid = 0.5 * ((double)a + b);
+    for (int k = first; k <= last; k++) {
+        double x = ((double)k / ArcLengthTable::SIZE - mid) / half, speed = 0.0;
+        for (int d = 4; d >= 0; d--)
+            speed = speed * x + poly[d];
+        if (std::abs(speed - table.speed[k]) * (b - a) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+// Arc-length at the knots in the piece [a, b] that starts at s: the sum of
+// the quadrature at b, the integral of the polynomial through the speeds at
+// its nodes inside
+void fillKnots(ArcLengthTable& table, float a, float b, const float* speeds, float sum, double s)
+{
+    const int N = ArcLengthTable::SIZE;
+    int first, last;
+    innerKnots(a, b, first, last);
+    if (last + 1 == b * N)
+        table.s[last + 1] = (float)(s + sum);
+    if (first > last) return;
+
+    const LagrangeBasis& basis = lagrangeBasis();
+    double poly[6] = {};
+    for (int i = 0; i < 5; i++)
+        for (int d = 0; d < 6; d++)
+            poly[d] += speeds[i] * basis.integral[i][d];
+    double half = 0.5 * ((double)b - a), mid = 0.5 * ((double)a + b);
+    for (int k = first; k <= last; k++) {
+        double x = ((double)k / N - mid) / half, value = 0.0;
+        for (int d = 5; d >= 0; d--)
+            value = value * x + poly[d];
+        table.s[k] = (float)(s + half * value);
+    }
+}
+
+// Split [a, b] until both halves agree with the whole within tolerance. With
+// a table, the halves must also follow the speed at the knots inside them;
+// the pieces the quadrature accepts then place the knots, s is the
+// arc-length at a and advances over the pieces in order
+float adaptiveSpeed(const Curve& curve, float a, float b, float whole, float tolerance,
+                    int depth, int& evaluations, ArcLengthTable* table, double& s)
+{
+    float mid = 0.5f * (a + b);
+    float leftSpeeds[5], rightSpeeds[5];
+    float left = integrateSpeed(curve, a, mid, evaluations, leftSpeeds);
+    float right = integrateSpeed(curve, mid, b, evaluations, rightSpeeds);
+    bool accept = std::abs(left + right - whole) <= tolerance;
+    if (accept && table)
+        accept = depth + 1 >= tableDepth &&
+                 followsKnots(*table, a, mid, leftSpeeds, 0.5f * tolerance) &&
+                 followsKnots(*table, mid, b, rightSpeeds, 0.5f * tolerance);
+    if (depth >= maxDepth || accept) {
+        if (table) {
+            fillKnots(*table, a, mid, leftSpeeds, left, s);
+            fillKnots(*table, mid, b, rightSpeeds, right, s + left);
+        }
+        s += (double)left + right;
+        return left + right;
+    }
+    return adaptiveSpeed(curve, a, mid, left, 0.5f * tolerance, depth + 1, evaluations, table, s) +
+           adaptiveSpeed(curve, mid, b, right, 0.5f * tolerance, depth + 1, evaluations, table, s);
+}
+
+}
+
+/******************************************************************************
+Calculate arc-length by adaptive Gauss-Legendre quadrature of ||C'(u)||, and
+the arc-length table that getU interpolates
+
+Entry:
+  tolerance - the absolute error allowed on the length
+
+Exit:
+  table   - arc-length and speed at the table knots, skipped when null;
+            unused by lines
+  returns the number of ||C'(u)|| evaluations spent
+
+The knots sit at uniformly spaced u, so they follow the curve: where it slows
+down they get closer in s, which is where u(s) bends the most. Their speed
+is evaluated first; their arc-length comes from the pieces the quadrature of
+the length accepts, which are split to at most 1 / 4 and until the speed
+through their nodes follows the knots. Knots inside a piece integrate that
+polynomial, so the table costs no speed evaluations beyond the knots
+******************************************************************************/
+int Curve::calculateFeatures(float tolerance, ArcLengthTable* table) {
+  // Lines have constant speed, so the length is exact and u(s) is linear
+  if (mDegree == 1) {
+    length = mMP.row(2).norm();
+    return 1;
+  }
+
+  const int N = ArcLengthTable::SIZE;
+  int evaluations = 0;
+  if (table) {
+    for (int k = 0; k <= N; k++)
+      table->speed[k] = getTangent((float)k / (float)N).norm();
+    evaluations += N + 1;
+  }
+  double s = 0.0;
+  float whole = integrateSpeed(*this, 0.0f, 1.0f, evaluations);
+  length = adaptiveSpeed(*this, 0.0f, 1.0f, whole, tolerance, 0, evaluations, table, s);
+  if (!table)
+    return evaluations;
+
+  // The polynomial of a piece may dip where the speed almost vanishes
+  table->s[0] = 0.0f;
+  for (int k = 1; k <= N; k++)
+    table->s[k] = std::max(table->s[k], table->s[k - 1]);
+
+  return evaluations;
+}
+
+/******************************************************************************
+Map an arc-length s in [0, length] to u
+
+Entry:
+  s     - arc-length from the start of the curve
+  table - the table calculateFeatures filled, may be null for lines
+
+Exit:
+  returns u with getS(u) = s
+
+Only reads the table: a cubic Hermite in s between the two knots around s,
+with the slopes du/ds = 1 / ||C'(u)|| stored at the knots. The slopes are
+limited to three times the mean slope of the piece so u(s) stays monotone
+where the curve almost stops
+******************************************************************************/
+float Curve::getU(float s, const ArcLengthTable* table) const {
+  if (length <= 0.0f) return 0.0f;
+  if (mDegree == 1 || !table) return std::clamp(s / length, 0.0f, 1.0f);
+  const int N = ArcLengthTable::SIZE;
+  s = std::clamp(s, 0.0f, table->s[N]);
+  int k = (int)(std::upper_bound(table->s + 1, table->s + N, s) - table->s) - 1;
+  float width = table->s[k + 1] - table->s[k];
+  float h = 1.0f / (float)N;
+  if (width <= 0.0f) return (float)k * h;
+
+  // Slopes du/dt over the piece t in [0, 1]
+  float t = (s - table->s[k]) / width;
+  float t2 = t * t, t3 = t2 * t;
+  float limit = 3.0f * h;
+  float speed0 = table->speed[k], speed1 = table->speed[k + 1];
+  float d0 = speed0 * limit > width ? width / speed0 : limit;
+  float d1 = speed1 * limit > width ? width / speed1 : limit;
+  return (2.0f * t3 - 3.0f * t2 + 1.0f) * (float)k * h + (t3 - 2.0f * t2 + t) * d0 +
+         (-2.0f * t3 + 3.0f * t2) * (float)(k + 1) * h + (t3 - t2) * d1;
 }
 
-// Calculate arc-length
-void Curve::calculateFeatures(int segments) {
-  length = 0.0f;
-  Eigen::Vector3f p0 = getPosition(0.0f);
-  for (int i = 1; i < segments; i++) {
-    float u = (float)i / (float)segments;
-    Eigen::Vector3f p1 = getPosition(u);
-    length += (p1 - p0).norm();
-    p0 = p1;
+// Arc-length from the start to u, integrated over pieces of at most
+// 1 / ArcLengthTable::SIZE like the knots of the table
+float Curve::getS(float u) const {
+  u = std::clamp(u, 0.0f, 1.0f);
+  if (mDegree == 1) return length * u;
+  int pieces = std::max(1, (int)std::ceil(u * ArcLengthTable::SIZE));
+  int evaluations = 0;
+  float ret = 0.0f;
+  for (int k = 0; k < pieces; k++)
+    ret += integrateSpeed(*this, u * k / pieces, u * (k + 1) / pieces, evaluations);
+  return ret;
+}
+
+/******************************************************************************
+Find the point of the curve closest to p
+
+Entry:
+  p - the point to project
+
+Exit:
+  u       - parameter of the closest point in [0, 1]
+  returns the squared distance from p to C(u)
+
+Newton's method on f(u) = (C(u) - p) . C'(u) starts from every sample that
+is closer than its neighbours, so each local minimum of the distance is
+refined on its own
+******************************************************************************/
+float Curve::closestPoint(const Eigen::Vector3f& p, float& u) const {
+  const int SAMPLES = 8;
+  const int ITERATIONS = 8;
+  if (mDegree == 1) {
+    const Eigen::Vector3f c = mMP.row(2).transpose(), d = mMP.row(3).transpose();
+    float len2 = c.squaredNorm();
+    u = len2 > 0.0f ? std::clamp((p - d).dot(c) / len2, 0.0f, 1.0f) : 0.0f;
+    return (c * u + d - p).squaredNorm();
+  }
+
+  float dist[SAMPLES + 1];
+  for (int k = 0; k <= SAMPLES; k++)
+    dist[k] = (getPosition((float)k / SAMPLES) - p).squaredNorm();
+
+  float best = dist[0];
+  u = 0.0f;
+  for (int k = 0; k <= SAMPLES; k++) {
+    if ((k > 0 && dist[k - 1] < dist[k]) || (k < SAMPLES && dist[k + 1] < dist[k]))
+      continue;
+    float x = (float)k / SAMPLES;
+    for (int i = 0; i < ITERATIONS; i++) {
+      CurvePoint c = evaluate(x);
+      Eigen::Vector3f r = c.position - p;
+      float f = r.dot(c.first);
+      float df = c.first.squaredNorm() + r.dot(c.second);
+      if (df <= 0.0f) break;
+      float next = std::clamp(x - f / df, 0.0f, 1.0f);
+      if (std::abs(next - x) < 1e-7f) { x = next; break; }
+      x = next;
+    }
+    float d = (getPosition(x) - p).squaredNorm();
+    if (d > dist[k]) {
+      x = (float)k / SAMPLES;
+      d = dist[k];
+    }
+    if (d < best) {
+      best = d;
+      u = x;
+    }
   }
+  return best;
+}
+
+// Number of samples taken per length
+int Curve::getNumSamples(float segLen) const
+{
+    return (int)(length / segLen);
+}
+
+// Aquire points, tangents and curvatures per length at u = i / numSeg,
+// only the first count samples if count >= 0
+void Curve::getSamples(float segLen, Eigen::Vector3f* points, Eigen::Vector3f* tangents, float* curvatures,
+                       int count) const
+{
+    const int chunk = 256;
+    float u[chunk];
+    int numSeg = getNumSamples(segLen);
+    int last = (count >= 0) ? std::min(count, numSeg) : numSeg;
+    for (int i = 0; i < last; i += chunk) {
+        int n = std::min(chunk, last - i);
+        for (int j = 0; j < n; j++)
+            u[j] = (float)(i + j) / (float)numSeg;
+        evaluate(u, n,
+            points ? points + i : nullptr,
+            tangents ? tangents + i : nullptr,
+            curvatures ? curvatures + i : nullptr);
+    }
+}
+
+/******************************************************************************
+Walk u = i / numSeg (i = 0 ... numSeg - 1) with cubic forward differencing,
+so that every step costs three vector adds instead of a polynomial evaluation.
+The walk re-anchors on the exact polynomial every few steps to bound drift.
+
+Entry:
+  numSeg - the number of samples
+  count  - only the first count samples are written if >= 0
+
+Exit:
+  points  - C(u) for each sample, skipped when null
+  firsts  - C'(u) for each sample, skipped when null
+  seconds - C''(u) for each sample, skipped when null
+******************************************************************************/
+void Curve::forwardDifference(int numSeg, Eigen::Vector3f* points, Eigen::Vector3f* firsts,
+                              Eigen::Vector3f* seconds, int count) const
+{
+    const int last = (count >= 0) ? std::min(count, numSeg) : numSeg;
+    const int anchorSteps = 32;
+    const float h = 1.0f / (float)numSeg;
+    // Padded to four lanes so every step is a single SIMD add per stream
+    Eigen::Array4f a, b, c, d;
+    a << mMP.row(0).transpose(), 0.0f;
+    b << mMP.row(1).transpose(), 0.0f;
+    c << mMP.row(2).transpose(), 0.0f;
+    d << mMP.row(3).transpose(), 0.0f;
+    const Eigen::Array4f d3P = 6.0f * a * h * h * h;
+    const Eigen::Array4f d2T = 6.0f * a * h * h;
+    const Eigen::Array4f dQ = 6.0f * a * h;
+
+    for (int start = 0; start < last; start += anchorSteps) {
+        // Anchor the differences on the exact polynomial at u
+        float u = (float)start * h;
+        Eigen::Array4f p = ((a * u + b) * u + c) * u + d;
+        Eigen::Array4f dP = (a * (3.0f * u * u + 3.0f * u * h + h * h) + b * (2.0f * u + h) + c) * h;
+        Eigen::Array4f d2P = (6.0f * a * (u + h) + 2.0f * b) * h * h;
+        Eigen::Array4f t = (3.0f * a * u + 2.0f * b) * u + c;
+        Eigen::Array4f dT = (3.0f * a * (2.0f * u + h) + 2.0f * b) * h;
+        Eigen::Array4f q = 6.0f * a * u + 2.0f * b;
+
+        int end = std::min(last, start + anchorSteps);
+        for (int i = start; i < end; i++) {
+            if (points) points[i] = p.head<3>();
+            if (firsts) firsts[i] = t.head<3>();
+            if (seconds) seconds[i] = q.head<3>();
+            p += dP;
+            dP += d2P;
+            d2P += d3P;
+            t += dT;
+            dT += d2T;
+            q += dQ;
+        }
+    }
 }
 
 // Aquire points per length
 void Curve::getPoints(float segLen, std::vector<Eigen::Vector3f>& points)
 {
-    int numSeg = (int)(length / segLen);
-    for (int i = 0; i < numSeg; i++) {
-        float u = (float)i / (float)numSeg;
-        points.push_back(getPosition(u));
-    }
+    size_t offset = points.size();
+    points.resize(offset + getNumSamples(segLen));
+    getSamples(segLen, points.data() + offset, nullptr, nullptr);
 }
 
 // Aquire tangent per length
 void Curve::getTangents(float segLen, std::vector<Eigen::Vector3f>& tangents)
 {
-    int numSeg = (int)(length / segLen);
-    for (int i = 0; i < numSeg; i++) {
-        float u = (float)i / (float)numSeg;
-        tangents.push_back(getTangent(u));
-    }
+    size_t offset = tangents.size();
+    tangents.resize(offset + getNumSamples(segLen));
+    getSamples(segLen, nullptr, tangents.data() + offset, nullptr);
 }
 
 // Aquire curvatures per length
 void Curve::getCurvatures(float segLen, std::vector<float>& curvatures)
 {
-    int numSeg = (int)(length / segLen);
-    for (int i = 0; i < numSeg; i++) {
-        float u = (float)i / (float)numSeg;
-        curvatures.push_back(getCurvature(u));
-    }
-}
\ No newline at end of file
+    size_t offset = curvatures.size();
+    curvatures.resize(offset + getNumSamples(segLen));
+    getSamples(segLen, nullptr, nullptr, curvatures.data() + offset);
+}
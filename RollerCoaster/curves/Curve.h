@@ -3,13 +3,45 @@
 #include <Eigen/Dense>
 #include <vector>
 
+// Position and derivatives of C(u) evaluated in a single pass
+struct CurvePoint
+{
+  Eigen::Vector3f position;   // C(u)
+  Eigen::Vector3f first;      // C'(u)
+  Eigen::Vector3f second;     // C''(u)
+};
+
+// Frenet frame of C at u, right-handed with binormal = tangent x normal
+struct FrenetFrame
+{
+  Eigen::Vector3f tangent;
+  Eigen::Vector3f normal;
+  Eigen::Vector3f binormal;
+  float curvature;            // ||C' x C''|| / ||C'||^3
+  float torsion;              // (C' x C'') . C''' / ||C' x C''||^2
+};
+
+// Arc-length s(u) of a curved segment for getU, kept by the spline next to
+// its curves; lines need none because their speed is constant
+struct ArcLengthTable
+{
+  static const int SIZE = 16;
+  float s[SIZE + 1];          // Arc-length at u = k / SIZE
+  float speed[SIZE + 1];      // ||C'(u)|| at u = k / SIZE
+};
+
 class Curve
 {
 private:
   Eigen::Matrix<float, 4, 3> mMP;
   float length;
+  unsigned char mDegree;      // Degree of the polynomial (1, 2 or 3)
+
+  void initialize();
 
 public:
+  // A point at the origin, for storage that is assigned later
+  Curve();
   Curve(
     const Eigen::Vector3f& a,
     const Eigen::Vector3f& b,
@@ -17,16 +49,99 @@ public:
     const Eigen::Vector3f& d,
     Eigen::Matrix4f& M
   );
+  Curve(const Eigen::Vector3f& a, const Eigen::Vector3f& b);
+  explicit Curve(const Eigen::Matrix<float, 4, 3>& mp);
 
-  Eigen::Vector3f getPosition(float u);
-  Eigen::Vector3f getTangent(float u);
-  float getCurvature(float u);
-  void calculateFeatures(int segments = 100);
+  CurvePoint evaluate(float u) const;
+  Eigen::Vector3f getPosition(float u) const;
+  Eigen::Vector3f getTangent(float u) const;
+  float getCurvature(float u) const;
+  static float curvature(const Eigen::Vector3f& first, const Eigen::Vector3f& second);
+  float getMaxCurvature(float& u) const;
+  FrenetFrame getFrenetFrame(float u) const;
+  void getFrenetFrames(const float* u, int n, FrenetFrame* frames) const;
+  void evaluate(const float* u, int n, Eigen::Vector3f* positions,
+                Eigen::Vector3f* tangents, float* curvatures) const;
+  // Length, and the arc-length table of a curved segment if table is not null
+  int calculateFeatures(float tolerance = 1e-4f, ArcLengthTable* table = nullptr);
+  float getU(float s, const ArcLengthTable* table) const;
+  float getS(float u) const;
+  float closestPoint(const Eigen::Vector3f& p, float& u) const;
 
+  int getNumSamples(float segLen) const;
+  void getSamples(float segLen, Eigen::Vector3f* points, Eigen::Vector3f* tangents, float* curvatures,
+                  int count = -1) const;
+  void forwardDifference(int numSeg, Eigen::Vector3f* points, Eigen::Vector3f* firsts,
+                         Eigen::Vector3f* seconds, int count = -1) const;
   void getPoints(float segLen, std::vector<Eigen::Vector3f>& points);
   void getTangents(float segLen, std::vector<Eigen::Vector3f>& tangent);
   void getCurvatures(float segLen, std::vector<float>& curvatures);
   inline Eigen::Matrix<float, 4, 3> getMP() const { return mMP; }
   inline float getLength() const { return length; }
+  inline int getDegree() const { return mDegree; }
+
+  // Bounds: the curve lies inside the convex hull of its Bezier control points.
+  // Both are derived from mMP on every call; the spline keeps the bounds of
+  // its curves up to date for its queries
+  Eigen::Matrix<float, 4, 3> getHull() const;
+  Eigen::AlignedBox3f getBounds() const;
+  Eigen::AlignedBox3f getHullBounds() const;
+  float getFlatness() const;
+  void subdivide(float t, Eigen::Matrix<float, 4, 3>& left, Eigen::Matrix<float, 4, 3>& right) const;
+  static void subdivide(const Eigen::Matrix<float, 4, 3>& hull, float t,
+                        Eigen::Matrix<float, 4, 3>& left, Eigen::Matrix<float, 4, 3>& right);
 
 };
+
+// Calculate C(u), C'(u) and C''(u) together with Horner's rule
+// mMP rows hold the coefficients of u^3, u^2, u and 1
+inline CurvePoint Curve::evaluate(float u) const {
+  const Eigen::Vector3f b = mMP.row(1).transpose();
+  const Eigen::Vector3f c = mMP.row(2).transpose();
+  const Eigen::Vector3f d = mMP.row(3).transpose();
+  CurvePoint ret;
+  switch (mDegree) {
+  case 1:
+    ret.position = c * u + d;
+    ret.first = c;
+    ret.second.setZero();
+    break;
+  case 2:
+    ret.position = (b * u + c) * u + d;
+    ret.first = 2.0f * b * u + c;
+    ret.second = 2.0f * b;
+    break;
+  default: {
+    const Eigen::Vector3f a = mMP.row(0).transpose();
+    ret.position = ((a * u + b) * u + c) * u + d;
+    ret.first = (3.0f * a * u + 2.0f * b) * u + c;
+    ret.second = 6.0f * a * u + 2.0f * b;
+    break;
+  }
+  }
+  return ret;
+}
+
+// Calculate C(u) = T * M * P
+inline Eigen::Vector3f Curve::getPosition(float u) const {
+  switch (mDegree) {
+  case 1:
+    return (mMP.row(2) * u + mMP.row(3)).transpose();
+  case 2:
+    return ((mMP.row(1) * u + mMP.row(2)) * u + mMP.row(3)).transpose();
+  default:
+    return (((mMP.row(0) * u + mMP.row(1)) * u + mMP.row(2)) * u + mMP.row(3)).transpose();
+  }
+}
+
+// Calculate the tangent vector C'(u) at u
+inline Eigen::Vector3f Curve::getTangent(float u) const {
+  switch (mDegree) {
+  case 1:
+    return mMP.row(2).transpose();
+  case 2:
+    return (2.0f * mMP.row(1) * u + mMP.row(2)).transpose();
+  default:
+    return ((3.0f * mMP.row(0) * u + 2.0f * mMP.row(1)) * u + mMP.row(2)).transpose();
+  }
+}
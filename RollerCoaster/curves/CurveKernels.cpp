@@ -0,0 +1,318 @@
+#include "CurveKernels.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CURVE_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#define TARGET_SSE
+#define TARGET_AVX2
+#define FORCE_INLINE __forceinline
+#else
+#define TARGET_SSE __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace {
+
+// Coefficients of C(u) = a u^3 + b u^2 + c u + d, split per axis
+struct Coefficients {
+  float a[3], b[3], c[3], d[3];
+};
+
+Coefficients loadCoefficients(const Eigen::Matrix<float, 4, 3> &mp) {
+  Coefficients k;
+  for (int j = 0; j < 3; j++) {
+    k.a[j] = mp(0, j);
+    k.b[j] = mp(1, j);
+    k.c[j] = mp(2, j);
+    k.d[j] = mp(3, j);
+  }
+  return k;
+}
+
+// Scatter lane arrays back into the Vector3f / float outputs. Inlined into
+// the kernels so the AVX2 loop never calls out into non-VEX code, which costs
+// an SSE/AVX transition per call when the build does not enable AVX
+template <int W>
+FORCE_INLINE void storeLanes(int i, const float (&p)[3][W], const float (&t)[3][W], const float (&k)[W],
+                       Eigen::Vector3f *positions, Eigen::Vector3f *tangents, float *curvatures) {
+  if (positions)
+    for (int j = 0; j < W; j++)
+      positions[i + j] = Eigen::Vector3f(p[0][j], p[1][j], p[2][j]);
+  if (tangents)
+    for (int j = 0; j < W; j++)
+      tangents[i + j] = Eigen::Vector3f(t[0][j], t[1][j], t[2][j]);
+  if (curvatures)
+    for (int j = 0; j < W; j++)
+      curvatures[i + j] = k[j];
+}
+
+void evaluateScalar(const Coefficients &k, const float *u, int begin, int n,
+                    Eigen::Vector3f *positions, Eigen::Vector3f *tangents, float *curvatures) {
+  for (int i = begin; i < n; i++) {
+    float x = u[i];
+    Eigen::Vector3f p, t, s;
+    for (int j = 0; j < 3; j++) {
+      p[j] = ((k.a[j] * x + k.b[j]) * x + k.c[j]) * x + k.d[j];
+      t[j] = (3.0f * k.a[j] * x + 2.0f * k.b[j]) * x + k.c[j];
+      s[j] = 6.0f * k.a[j] * x + 2.0f * k.b[j];
+    }
+    if (positions)
+      positions[i] = p;
+    if (tangents)
+      tangents[i] = t;
+    if (curvatures) {
+      float speed2 = t.squaredNorm();
+      float denominator = speed2 * std::sqrt(speed2);
+      curvatures[i] = denominator < 1e-6f ? 0.0f : t.cross(s).norm() / denominator;
+    }
+  }
+}
+
+#ifdef CURVE_KERNELS_X86
+
+// ||t x s|| / ||t||^3 per lane, zero where ||t||^3 is too small
+TARGET_SSE inline __m128 curvatureSSE(const __m128 (&t)[3], const __m128 (&s)[3]) {
+  const __m128 eps = _mm_set1_ps(1e-6f);
+  __m128 cx = _mm_sub_ps(_mm_mul_ps(t[1], s[2]), _mm_mul_ps(t[2], s[1]));
+  __m128 cy = _mm_sub_ps(_mm_mul_ps(t[2], s[0]), _mm_mul_ps(t[0], s[2]));
+  __m128 cz = _mm_sub_ps(_mm_mul_ps(t[0], s[1]), _mm_mul_ps(t[1], s[0]));
+  __m128 cross = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz)));
+  __m128 speed2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(t[0], t[0]), _mm_mul_ps(t[1], t[1])), _mm_mul_ps(t[2], t[2]));
+  __m128 denominator = _mm_mul_ps(speed2, _mm_sqrt_ps(speed2));
+  __m128 valid = _mm_cmpge_ps(denominator, eps);
+  return _mm_and_ps(valid, _mm_div_ps(cross, _mm_max_ps(denominator, eps)));
+}
+
+TARGET_AVX2 inline __m256 curvatureAVX2(const __m256 (&t)[3], const __m256 (&s)[3]) {
+  const __m256 eps = _mm256_set1_ps(1e-6f);
+  __m256 cx = _mm256_fmsub_ps(t[1], s[2], _mm256_mul_ps(t[2], s[1]));
+  __m256 cy = _mm256_fmsub_ps(t[2], s[0], _mm256_mul_ps(t[0], s[2]));
+  __m256 cz = _mm256_fmsub_ps(t[0], s[1], _mm256_mul_ps(t[1], s[0]));
+  __m256 cross = _mm256_sqrt_ps(_mm256_fmadd_ps(cx, cx, _mm256_fmadd_ps(cy, cy, _mm256_mul_ps(cz, cz))));
+  __m256 speed2 = _mm256_fmadd_ps(t[0], t[0], _mm256_fmadd_ps(t[1], t[1], _mm256_mul_ps(t[2], t[2])));
+  __m256 denominator = _mm256_mul_ps(speed2, _mm256_sqrt_ps(speed2));
+  __m256 valid = _mm256_cmp_ps(denominator, eps, _CMP_GE_OQ);
+  return _mm256_and_ps(valid, _mm256_div_ps(cross, _mm256_max_ps(denominator, eps)));
+}
+
+TARGET_SSE int evaluateSSE(const Coefficients &k, const float *u, int n,
+                           Eigen::Vector3f *positions, Eigen::Vector3f *tangents,
+                           float *curvatures) {
+  __m128 a[3], b[3], c[3], d[3], a3[3], b2[3], a6[3];
+  for (int j = 0; j < 3; j++) {
+    a[j] = _mm_set1_ps(k.a[j]);
+    b[j] = _mm_set1_ps(k.b[j]);
+    c[j] = _mm_set1_ps(k.c[j]);
+    d[j] = _mm_set1_ps(k.d[j]);
+    a3[j] = _mm_set1_ps(3.0f * k.a[j]);
+    b2[j] = _mm_set1_ps(2.0f * k.b[j]);
+    a6[j] = _mm_set1_ps(6.0f * k.a[j]);
+  }
+  alignas(16) float p[3][4], t[3][4], kappa[4];
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 x = _mm_loadu_ps(u + i);
+    __m128 vt[3], vs[3];
+    for (int j = 0; j < 3; j++) {
+      __m128 vp = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a[j], x), b[j]), x), c[j]), x), d[j]);
+      vt[j] = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a3[j], x), b2[j]), x), c[j]);
+      vs[j] = _mm_add_ps(_mm_mul_ps(a6[j], x), b2[j]);
+      _mm_store_ps(p[j], vp);
+      _mm_store_ps(t[j], vt[j]);
+    }
+    if (curvatures)
+      _mm_store_ps(kappa, curvatureSSE(vt, vs));
+    storeLanes<4>(i, p, t, kappa, positions, tangents, curvatures);
+  }
+  return i;
+}
+
+TARGET_AVX2 int evaluateAVX2(const Coefficients &k, const float *u, int n,
+                             Eigen::Vector3f *positions, Eigen::Vector3f *tangents,
+                             float *curvatures) {
+  __m256 a[3], b[3], c[3], d[3], a3[3], b2[3], a6[3];
+  for (int j = 0; j < 3; j++) {
+    a[j] = _mm256_set1_ps(k.a[j]);
+    b[j] = _mm256_set1_ps(k.b[j]);
+    c[j] = _mm256_set1_ps(k.c[j]);
+    d[j] = _mm256_set1_ps(k.d[j]);
+    a3[j] = _mm256_set1_ps(3.0f * k.a[j]);
+    b2[j] = _mm256_set1_ps(2.0f * k.b[j]);
+    a6[j] = _mm256_set1_ps(6.0f * k.a[j]);
+  }
+  alignas(32) float p[3][8], t[3][8], kappa[8];
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 x = _mm256_loadu_ps(u + i);
+    __m256 vt[3], vs[3];
+    for (int j = 0; j < 3; j++) {
+      __m256 vp = _mm256_fmadd_ps(_mm256_fmadd_ps(_mm256_fmadd_ps(a[j], x, b[j]), x, c[j]), x, d[j]);
+      vt[j] = _mm256_fmadd_ps(_mm256_fmadd_ps(a3[j], x, b2[j]), x, c[j]);
+      vs[j] = _mm256_fmadd_ps(a6[j], x, b2[j]);
+      _mm256_store_ps(p[j], vp);
+      _mm256_store_ps(t[j], vt[j]);
+    }
+    if (curvatures)
+      _mm256_store_ps(kappa, curvatureAVX2(vt, vs));
+    storeLanes<8>(i, p, t, kappa, positions, tangents, curvatures);
+  }
+  return i;
+}
+
+TARGET_SSE int curvaturesSSE(const Eigen::Vector3f *firsts, const Eigen::Vector3f *seconds, int n,
+                             float *curvatures) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 t[3], s[3];
+    for (int j = 0; j < 3; j++) {
+      t[j] = _mm_setr_ps(firsts[i][j], firsts[i + 1][j], firsts[i + 2][j], firsts[i + 3][j]);
+      s[j] = _mm_setr_ps(seconds[i][j], seconds[i + 1][j], seconds[i + 2][j], seconds[i + 3][j]);
+    }
+    _mm_storeu_ps(curvatures + i, curvatureSSE(t, s));
+  }
+  return i;
+}
+
+TARGET_AVX2 int curvaturesAVX2(const Eigen::Vector3f *firsts, const Eigen::Vector3f *seconds, int n,
+                               float *curvatures) {
+  // Vector3f is packed, so lane k of axis j sits at float offset 3k + j
+  const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 t[3], s[3];
+    for (int j = 0; j < 3; j++) {
+      t[j] = _mm256_i32gather_ps(firsts[i].data() + j, stride, 4);
+      s[j] = _mm256_i32gather_ps(seconds[i].data() + j, stride, 4);
+    }
+    _mm256_storeu_ps(curvatures + i, curvatureAVX2(t, s));
+  }
+  return i;
+}
+
+bool cpuHasAVX2() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  bool fma = (info[2] & (1 << 12)) != 0;
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  if (!(fma && osxsave && avx) || (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif
+
+CurveKernels::ISA detectISA() {
+#ifdef CURVE_KERNELS_X86
+  return cpuHasAVX2() ? CurveKernels::ISA::AVX2 : CurveKernels::ISA::SSE;
+#else
+  return CurveKernels::ISA::Scalar;
+#endif
+}
+
+CurveKernels::ISA &activeISA() {
+  static CurveKernels::ISA isa = detectISA();
+  return isa;
+}
+
+} // namespace
+
+/******************************************************************************
+Evaluate positions, tangents C'(u) and curvatures for n parameters
+
+Entry:
+  mp - the M * P coefficients of the curve
+  u  - the parameters to evaluate
+  n  - the number of parameters
+
+Exit:
+  positions, tangents, curvatures - n outputs each, skipped when null
+******************************************************************************/
+void CurveKernels::evaluate(const Eigen::Matrix<float, 4, 3> &mp, const float *u, int n,
+                            Eigen::Vector3f *positions, Eigen::Vector3f *tangents,
+                            float *curvatures) {
+  Coefficients k = loadCoefficients(mp);
+  int done = 0;
+#ifdef CURVE_KERNELS_X86
+  switch (activeISA()) {
+  case ISA::AVX2:
+    done = evaluateAVX2(k, u, n, positions, tangents, curvatures);
+    break;
+  case ISA::SSE:
+    done = evaluateSSE(k, u, n, positions, tangents, curvatures);
+    break;
+  default:
+    break;
+  }
+#endif
+  evaluateScalar(k, u, done, n, positions, tangents, curvatures);
+}
+
+/******************************************************************************
+Curvatures ||C' x C''|| / ||C'||^3 of n precomputed derivative pairs
+
+Entry:
+  firsts  - C'(u) of each sample
+  seconds - C''(u) of each sample
+  n       - the number of samples
+
+Exit:
+  curvatures - n curvatures
+******************************************************************************/
+void CurveKernels::curvatures(const Eigen::Vector3f *firsts, const Eigen::Vector3f *seconds, int n,
+                              float *curvatures) {
+  int done = 0;
+#ifdef CURVE_KERNELS_X86
+  switch (activeISA()) {
+  case ISA::AVX2:
+    done = curvaturesAVX2(firsts, seconds, n, curvatures);
+    break;
+  case ISA::SSE:
+    done = curvaturesSSE(firsts, seconds, n, curvatures);
+    break;
+  default:
+    break;
+  }
+#endif
+  for (int i = done; i < n; i++) {
+    float speed2 = firsts[i].squaredNorm();
+    float denominator = speed2 * std::sqrt(speed2);
+    curvatures[i] = denominator < 1e-6f ? 0.0f : firsts[i].cross(seconds[i]).norm() / denominator;
+  }
+}
+
+CurveKernels::ISA CurveKernels::getISA() { return activeISA(); }
+
+void CurveKernels::setISA(ISA isa) {
+  // Never select an instruction set the CPU does not have
+  ISA best = detectISA();
+  activeISA() = (int)isa > (int)best ? best : isa;
+}
+
+const char *CurveKernels::getISAName(ISA isa) {
+  switch (isa) {
+  case ISA::AVX2:
+    return "AVX2";
+  case ISA::SSE:
+    return "SSE";
+  default:
+    return "Scalar";
+  }
+}
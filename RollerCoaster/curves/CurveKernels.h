@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+// Batch evaluation of a cubic C(u) = [u^3 u^2 u 1] * MP over many parameters.
+// The SSE / AVX2 path is picked at runtime, the scalar path is the fallback.
+class CurveKernels {
+public:
+  CurveKernels() = delete;
+
+  enum class ISA { Scalar = 0, SSE = 1, AVX2 = 2 };
+
+  // Evaluate n parameters u[0..n-1]; any output pointer may be null
+  static void evaluate(const Eigen::Matrix<float, 4, 3> &mp, const float *u, int n,
+                       Eigen::Vector3f *positions, Eigen::Vector3f *tangents,
+                       float *curvatures);
+  // Curvatures from n precomputed first / second derivative pairs
+  static void curvatures(const Eigen::Vector3f *firsts, const Eigen::Vector3f *seconds, int n,
+                         float *curvatures);
+
+  // Instruction set used by evaluate, and an override for benchmarking
+  static ISA getISA();
+  static void setISA(ISA isa);
+  static const char *getISAName(ISA isa);
+};
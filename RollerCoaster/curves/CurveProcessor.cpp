@@ -1,82 +1,355 @@
 #include "CurveProcessor.h"
 #include "BSpline.h"
 #include "CatmullRom.h"
+#include "CurveKernels.h"
+#include "Parallel.h"
 #include "Polyline.h"
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <limits>
 
-void CurveProcessor::samplePoints(Spline *spline, float segLen,
-                                  std::vector<Eigen::Vector3f> &all_points,
-                                  std::vector<Eigen::Vector3f> &all_tangents,
-                                  std::vector<Eigen::Vector3f> &all_normals,
-                                  std::vector<float> &all_curvatures) {
-  std::vector<Curve> curves = spline->getCurves();
-  Eigen::Vector3f binormal = Eigen::Vector3f::Zero();
-  // Iterate for each Curves
-  for (int i = 0; i < spline->getNumCurves(); i++) {
-    Curve &c = spline->getCurves()[i];
-    // Take the features point and tangents from the curves
-    std::vector<Eigen::Vector3f> points;
-    c.getPoints(segLen, points);
-    std::vector<Eigen::Vector3f> tangents;
-    c.getTangents(segLen, tangents);
-    std::vector<float> curvatures;
-    c.getCurvatures(segLen, curvatures);
-    // Insert it to vector for spline
-    all_points.insert(all_points.end(), points.begin(), points.end());
-    all_tangents.insert(all_tangents.end(), tangents.begin(), tangents.end());
-    all_curvatures.insert(all_curvatures.end(), curvatures.begin(), curvatures.end());
-
-    //
-    if ((spline->getType() != Spline::Type::Polyline) &&
-        (spline->getLoop() || i < spline->getNumCurves() - 1)) {
-      all_points.pop_back();
-      all_tangents.pop_back();
-      all_curvatures.pop_back();
+// Samples curve i of count keeps, the last one is dropped where the next curve starts
+static int keptSamples(Spline *spline, int i, int count, int numSamples) {
+  bool seam = (spline->getType() != Spline::Type::Polyline) &&
+              (spline->getLoop() || i < count - 1);
+  return (seam && numSamples > 0) ? numSamples - 1 : numSamples;
+}
+
+// Propagate the normal over n tangents, starting from one perpendicular to
+// an up vector while binormal is still zero
+static void propagateNormals(const Eigen::Vector3f *tangents, Eigen::Vector3f *normals, int n,
+                             Eigen::Vector3f &binormal) {
+  for (int j = 0; j < n; j++) {
+    const Eigen::Vector3f &tangent = tangents[j];
+    Eigen::Vector3f normal;
+    if (binormal == Eigen::Vector3f::Zero()) {
+      Eigen::Vector3f up = Eigen::Vector3f(0.0f, 1.0f, 0.0f);
+      if (tangent.dot(up) > 0.99f)
+        up = Eigen::Vector3f(1.0f, 0.0f, 0.0f);
+      normal = tangent.cross(up).normalized();
+    } else {
+      normal = tangent.cross(binormal).normalized();
     }
-    // Calculate the binormal
-    for (auto &tangent : tangents) {
-      Eigen::Vector3f normal;
-      // First initialize the last binormal, I'm afraid the starting tangent will be same as
-      // upvector
-      if (binormal == Eigen::Vector3f::Zero()) {
-        Eigen::Vector3f up = Eigen::Vector3f(0.0f, 1.0f, 0.0f);
-        if (tangent.dot(up) > 0.99f)
-          up = Eigen::Vector3f(1.0f, 0.0f, 0.0f);
-        normal = tangent.cross(up).normalized();
-        binormal = normal.cross(tangent).normalized();
-      }
-      // If it's not the first one, we can safely use the last binormal
-      else {
-        normal = tangent.cross(binormal).normalized();
-        binormal = normal.cross(tangent).normalized();
+    binormal = normal.cross(tangent).normalized();
+    normals[j] = normal;
+  }
+}
+
+// Curves handed to a thread at least, so small tracks stay on one thread
+static const int SAMPLE_GRAIN = 64;
+
+// Resize the outputs to total samples, the capacity is kept between calls
+static void resizeSamples(TrackSamples &samples, int total) {
+  samples.positions.resize(total);
+  samples.tangents.resize(total);
+  samples.normals.resize(total);
+  samples.curvatures.resize(total);
+}
+
+/******************************************************************************
+Sample the track for rendering
+
+Entry:
+  spline - the spline to sample
+  segLen - the length between samples
+  mode   - how the curves are evaluated
+
+Exit:
+  samples - positions, tangents, normals and curvatures of the track
+
+The sample counts of the curves are summed into output offsets first, so
+every curve writes its own range of the buffers and the curves are sampled
+on several threads; the normals are propagated along the whole track in a
+second pass. The buffers keep their capacity, so resampling a track of the
+same size does not allocate
+******************************************************************************/
+void CurveProcessor::sampleTrack(Spline *spline, float segLen, TrackSamples &samples,
+                                 SampleMode mode) {
+  const std::vector<Curve> &curves = spline->getCurves();
+  int count = (int)curves.size();
+  samples.offsets.resize(count + 1);
+  samples.offsets[0] = 0;
+  for (int i = 0; i < count; i++)
+    samples.offsets[i + 1] =
+        samples.offsets[i] + keptSamples(spline, i, count, curves[i].getNumSamples(segLen));
+  int total = samples.offsets[count];
+  resizeSamples(samples, total);
+  if (mode == SampleMode::ForwardDifference)
+    samples.seconds.resize(total);
+
+  Parallel::forRange(count, SAMPLE_GRAIN, [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      const Curve &c = curves[i];
+      int offset = samples.offsets[i];
+      int kept = samples.offsets[i + 1] - offset;
+      Eigen::Vector3f *points = samples.positions.data() + offset;
+      Eigen::Vector3f *tangents = samples.tangents.data() + offset;
+      float *curvatures = samples.curvatures.data() + offset;
+      if (mode == SampleMode::ForwardDifference) {
+        Eigen::Vector3f *seconds = samples.seconds.data() + offset;
+        c.forwardDifference(c.getNumSamples(segLen), points, tangents, seconds, kept);
+        CurveKernels::curvatures(tangents, seconds, kept, curvatures);
+      } else {
+        c.getSamples(segLen, points, tangents, curvatures, kept);
       }
-      // Push it
-      all_normals.push_back(normal);
     }
+  });
+
+  Eigen::Vector3f binormal = Eigen::Vector3f::Zero();
+  propagateNormals(samples.tangents.data(), samples.normals.data(), total, binormal);
+}
+
+// Distance from p to the segment a b
+static float segmentDistance(const Eigen::Vector3f &p, const Eigen::Vector3f &a,
+                             const Eigen::Vector3f &b) {
+  Eigen::Vector3f ab = b - a;
+  float len2 = ab.squaredNorm();
+  float t = len2 > 0.0f ? std::clamp((p - a).dot(ab) / len2, 0.0f, 1.0f) : 0.0f;
+  return (a + t * ab - p).norm();
+}
+
+/******************************************************************************
+Split [u0, u1] of a curve until it is flat enough and write the start of
+every accepted piece to params
+
+Entry:
+  c          - the curve
+  u0, u1     - the piece, with positions p0, p1 and tangents t0, t1
+  chordal    - largest distance of the curve from the chord of a piece
+  cosAngle   - cosine of the largest turn of the tangent over a piece
+  depth      - splits so far
+
+Exit:
+  params     - receives the parameters at params[n], null to only count
+  n          - incremented by the number of pieces
+
+The chord is checked at a quarter, half and three quarters of the piece so
+an S-shaped piece crossing its chord in the middle is still split
+******************************************************************************/
+static void adaptiveParameters(const Curve &c, float u0, const Eigen::Vector3f &p0,
+                               const Eigen::Vector3f &t0, float u1, const Eigen::Vector3f &p1,
+                               const Eigen::Vector3f &t1, float chordal, float cosAngle,
+                               int depth, float *params, int &n) {
+  const int MIN_DEPTH = 1;
+  const int MAX_DEPTH = 12;
+  float um = 0.5f * (u0 + u1);
+  Eigen::Vector3f pm = c.getPosition(um);
+  bool split = depth < MIN_DEPTH && c.getDegree() > 1;
+  if (!split && depth < MAX_DEPTH) {
+    float scale = t0.norm() * t1.norm();
+    split = (scale > 0.0f && t0.dot(t1) < cosAngle * scale) ||
+            segmentDistance(pm, p0, p1) > chordal ||
+            segmentDistance(c.getPosition(0.5f * (u0 + um)), p0, p1) > chordal ||
+            segmentDistance(c.getPosition(0.5f * (um + u1)), p0, p1) > chordal;
   }
+  if (!split) {
+    if (params)
+      params[n] = u0;
+    n++;
+    return;
+  }
+  Eigen::Vector3f tm = c.getTangent(um);
+  adaptiveParameters(c, u0, p0, t0, um, pm, tm, chordal, cosAngle, depth + 1, params, n);
+  adaptiveParameters(c, um, pm, tm, u1, p1, t1, chordal, cosAngle, depth + 1, params, n);
+}
+
+// Pieces of a whole curve, see adaptiveParameters
+static int adaptiveParameters(const Curve &c, float chordal, float cosAngle, float *params) {
+  int n = 0;
+  adaptiveParameters(c, 0.0f, c.getPosition(0.0f), c.getTangent(0.0f), 1.0f, c.getPosition(1.0f),
+                     c.getTangent(1.0f), chordal, cosAngle, 0, params, n);
+  return n;
 }
 
-void CurveProcessor::sampleCurvature(Spline* spline, float segLen, std::vector<float>& all_curvatures)
-{
-    std::vector<Curve> curves = spline->getCurves();
-    Eigen::Vector3f binormal = Eigen::Vector3f::Zero();
-    // Iterate for each Curves
-    for (int i = 0; i < spline->getNumCurves(); i++) {
-        Curve& c = spline->getCurves()[i];
-        // Take the features point and tangents from the curves
-        std::vector<Eigen::Vector3f> points;
-        c.getPoints(segLen, points);
-        std::vector<Eigen::Vector3f> tangents;
-        c.getTangents(segLen, tangents);
-        std::vector<float> curvatures;
-        c.getCurvatures(segLen, curvatures);
-        // Insert it to vector for spline
-        all_curvatures.insert(all_curvatures.end(), curvatures.begin(), curvatures.end());
-        if ((spline->getType() != Spline::Type::Polyline) &&
-            (spline->getLoop() || i < spline->getNumCurves() - 1)) {
-            all_curvatures.pop_back();
-        }
+/******************************************************************************
+Sample the track densely where it bends and sparsely where it is straight
+
+Entry:
+  spline  - the spline to sample
+  chordal - largest distance of the track from the straight line between
+            two samples
+  angle   - largest turn of the tangent between two samples, in radians
+
+Exit:
+  samples - positions, tangents, normals and curvatures of the track
+
+Every curve contributes the starts of its pieces, an open track also ends
+with the end of its last curve. The curves are subdivided twice on several
+threads, once to count their pieces into output offsets and once to write
+and evaluate them; the normals follow in a sequential pass
+******************************************************************************/
+void CurveProcessor::sampleTrackAdaptive(Spline *spline, float chordal, float angle,
+                                         TrackSamples &samples) {
+  const std::vector<Curve> &curves = spline->getCurves();
+  int count = (int)curves.size();
+  float cosAngle = std::cos(angle);
+  bool end = count > 0 && !spline->getLoop();
+
+  samples.offsets.resize(count + 1);
+  samples.offsets[0] = 0;
+  Parallel::forRange(count, SAMPLE_GRAIN, [&](int begin, int last) {
+    for (int i = begin; i < last; i++)
+      samples.offsets[i + 1] = adaptiveParameters(curves[i], chordal, cosAngle, nullptr);
+  });
+  for (int i = 0; i < count; i++)
+    samples.offsets[i + 1] += samples.offsets[i];
+  if (end)
+    samples.offsets[count]++;
+  int total = samples.offsets[count];
+  resizeSamples(samples, total);
+  samples.parameters.resize(total);
+
+  Parallel::forRange(count, SAMPLE_GRAIN, [&](int begin, int last) {
+    for (int i = begin; i < last; i++) {
+      const Curve &c = curves[i];
+      int offset = samples.offsets[i];
+      int n = adaptiveParameters(c, chordal, cosAngle, samples.parameters.data() + offset);
+      if (end && i == count - 1)
+        samples.parameters[offset + n++] = 1.0f;
+      c.evaluate(samples.parameters.data() + offset, n, samples.positions.data() + offset,
+                 samples.tangents.data() + offset, samples.curvatures.data() + offset);
+    }
+  });
+
+  Eigen::Vector3f binormal = Eigen::Vector3f::Zero();
+  propagateNormals(samples.tangents.data(), samples.normals.data(), total, binormal);
+}
+
+/******************************************************************************
+Evaluate the curves of a track at parameters chosen per curve and hand the
+samples to sink in chunks of bounded size
+
+Entry:
+  spline     - the spline to sample
+  chunkSize  - most samples handed to sink at once
+  sink       - receives every chunk with the index of its first sample,
+               returns false to stop
+  parameters - start(i) returns the number of samples of curve i, write(j,
+               n, u) then writes its parameters j .. j + n - 1 to u
+
+Exit:
+  returns the number of samples handed to sink
+
+A curve may span several chunks and the normals are propagated across chunk
+borders. Only one chunk is held, so tracks of any length can be walked in
+constant memory
+******************************************************************************/
+template <typename Parameters>
+static int streamCurves(Spline *spline, int chunkSize, const CurveProcessor::SampleSink &sink,
+                        Parameters &parameters) {
+  const std::vector<Curve> &curves = spline->getCurves();
+  int count = (int)curves.size();
+  chunkSize = std::max(chunkSize, 1);
+  TrackSamples chunk;
+  resizeSamples(chunk, chunkSize);
+  chunk.parameters.resize(chunkSize);
+
+  Eigen::Vector3f binormal = Eigen::Vector3f::Zero();
+  int streamed = 0, filled = 0;
+  auto flush = [&]() {
+    propagateNormals(chunk.tangents.data(), chunk.normals.data(), filled, binormal);
+    if (filled < chunkSize)
+      resizeSamples(chunk, filled);
+    bool more = sink(chunk, streamed);
+    streamed += filled;
+    filled = 0;
+    return more;
+  };
+
+  for (int i = 0; i < count; i++) {
+    const Curve &c = curves[i];
+    int kept = parameters.start(i);
+    for (int j = 0; j < kept;) {
+      int n = std::min(kept - j, chunkSize - filled);
+      float *u = chunk.parameters.data() + filled;
+      parameters.write(j, n, u);
+      c.evaluate(u, n, chunk.positions.data() + filled, chunk.tangents.data() + filled,
+                 chunk.curvatures.data() + filled);
+      filled += n;
+      j += n;
+      if (filled == chunkSize && !flush())
+        return streamed;
+    }
+  }
+  if (filled > 0)
+    flush();
+  return streamed;
+}
+
+// The samples of sampleTrack, uniformly spaced in u on every curve
+int CurveProcessor::streamTrack(Spline *spline, float segLen, int chunkSize,
+                                const SampleSink &sink) {
+  struct Uniform {
+    Spline *spline;
+    float segLen;
+    int numSeg;
+    int start(int i) {
+      const std::vector<Curve> &curves = spline->getCurves();
+      numSeg = curves[i].getNumSamples(segLen);
+      return keptSamples(spline, i, (int)curves.size(), numSeg);
     }
+    void write(int j, int n, float *u) {
+      for (int k = 0; k < n; k++)
+        u[k] = (float)(j + k) / (float)numSeg;
+    }
+  } uniform{spline, segLen, 0};
+  return streamCurves(spline, chunkSize, sink, uniform);
+}
+
+// The samples of sampleTrackAdaptive, the pieces of one curve are held at a
+// time
+int CurveProcessor::streamTrackAdaptive(Spline *spline, float chordal, float angle,
+                                        int chunkSize, const SampleSink &sink) {
+  struct Adaptive {
+    Spline *spline;
+    float chordal, cosAngle;
+    std::vector<float> pieces;
+    int start(int i) {
+      const std::vector<Curve> &curves = spline->getCurves();
+      const Curve &c = curves[i];
+      int n = adaptiveParameters(c, chordal, cosAngle, nullptr);
+      bool end = !spline->getLoop() && i == (int)curves.size() - 1;
+      pieces.resize(n + (end ? 1 : 0));
+      adaptiveParameters(c, chordal, cosAngle, pieces.data());
+      if (end)
+        pieces[n] = 1.0f;
+      return (int)pieces.size();
+    }
+    void write(int j, int n, float *u) {
+      std::copy(pieces.begin() + j, pieces.begin() + j + n, u);
+    }
+  } adaptive{spline, chordal, std::cos(angle), {}};
+  return streamCurves(spline, chunkSize, sink, adaptive);
+}
+
+/******************************************************************************
+Find the maximum curvature of the spline without sampling it
+
+Entry:
+  spline - spline to inspect
+  curves - optional output for the extremum of every curve
+
+Exit:
+  returns the extremum of the whole spline, radius is infinite for a
+  straight track
+******************************************************************************/
+CurveProcessor::CurvatureExtremum
+CurveProcessor::findMaxCurvature(Spline *spline, std::vector<CurvatureExtremum> *curves) {
+  CurvatureExtremum ret = {-1, 0.0f, 0.0f, std::numeric_limits<float>::infinity()};
+  if (curves)
+    curves->resize(spline->getNumCurves());
+  for (int i = 0; i < spline->getNumCurves(); i++) {
+    CurvatureExtremum e;
+    e.curve = i;
+    e.curvature = spline->getCurves()[i].getMaxCurvature(e.u);
+    e.radius = e.curvature > 0.0f ? 1.0f / e.curvature : std::numeric_limits<float>::infinity();
+    if (curves)
+      (*curves)[i] = e;
+    if (ret.curve < 0 || e.curvature > ret.curvature)
+      ret = e;
+  }
+  return ret;
 }
 
 /******************************************************************************
@@ -109,7 +382,7 @@ void CurveProcessor::saveSpline(Spline *spline) {
   if (!spline)
     return;
 
-  std::vector<Eigen::Vector3f> &points = spline->getPoints();
+  const ControlPoints &points = spline->getPoints();
   std::ofstream outFile("spline.txt");
 
   if (!outFile) {
@@ -126,6 +399,57 @@ void CurveProcessor::saveSpline(Spline *spline) {
   outFile.close();
 }
 
+/******************************************************************************
+Export the samples of the track as text
+
+Entry:
+  spline   - the spline to sample
+  settings - the cache whose sample length or tolerances are used, so the
+             file holds the samples the tube is drawn from
+  path     - the file to write
+
+Exit:
+  returns false if the file cannot be written
+
+Every line holds the position, unit tangent, normal and curvature of one
+sample. The track is streamed, so only one chunk of samples is in memory
+******************************************************************************/
+bool CurveProcessor::exportTrack(Spline *spline, const TrackCache &settings,
+                                 const std::string &path) {
+  if (!spline)
+    return false;
+
+  std::ofstream outFile(path);
+  if (!outFile) {
+    std::cerr << "Error writing file\n";
+    return false;
+  }
+
+  const int CHUNK_SIZE = 4096;
+  auto write = [&](const TrackSamples &chunk, int) {
+    for (int i = 0; i < chunk.size(); i++) {
+      const Eigen::Vector3f &p = chunk.positions[i];
+      Eigen::Vector3f t = chunk.tangents[i].normalized();
+      const Eigen::Vector3f &n = chunk.normals[i];
+      outFile << p.x() << " " << p.y() << " " << p.z() << " " << t.x() << " " << t.y() << " "
+              << t.z() << " " << n.x() << " " << n.y() << " " << n.z() << " "
+              << chunk.curvatures[i] << "\n";
+    }
+    return (bool)outFile;
+  };
+  if (settings.getAdaptive())
+    streamTrackAdaptive(spline, settings.getChordalTolerance(), settings.getAngleTolerance(),
+                        CHUNK_SIZE, write);
+  else
+    streamTrack(spline, settings.getSampleLength(), CHUNK_SIZE, write);
+
+  if (!outFile) {
+    std::cerr << "Error writing file\n";
+    return false;
+  }
+  return true;
+}
+
 bool CurveProcessor::loadSpline(Model *model) {
   std::ifstream inFile("spline.txt");
   if (!inFile) {
@@ -151,18 +475,93 @@ bool CurveProcessor::loadSpline(Model *model) {
     model->setSpline(new BSpline());
     break;
   }
-  model->getSpline()->setAntribute(points, loop);
+  model->getSpline()->setAntribute(std::move(points), loop);
 
   return true;
 }
 
+// Header of a binary spline file, followed by the control points as floats
+struct SplineFileHeader {
+  char magic[4];        // "RCSP"
+  int version;
+  int type;
+  int loop;
+};
+
+/******************************************************************************
+Save the spline with its control points as raw floats
+
+Entry:
+  spline - the spline to save
+  path   - the file to write
+******************************************************************************/
+void CurveProcessor::saveSplineBinary(Spline *spline, const std::string &path) {
+  if (!spline)
+    return;
+
+  // Points loaded from path are copied first, Windows cannot replace a mapped file
+  if (spline->getPoints().isMappedFrom(path))
+    spline->unmapPoints();
+  SplineFileHeader header = {{'R', 'C', 'S', 'P'}, 1, (int)spline->getType(), (int)spline->getLoop()};
+  if (!spline->getPoints().save(path, &header, sizeof(header)))
+    std::cerr << "Error writing file\n";
+}
+
+/******************************************************************************
+Load a spline saved by saveSplineBinary
+
+Entry:
+  model - receives the new spline
+  path  - the file to read
+
+Exit:
+  returns false if the file cannot be read
+
+The control points are memory-mapped rather than read, the spline copies
+them only when one of them is edited
+******************************************************************************/
+bool CurveProcessor::loadSplineBinary(Model *model, const std::string &path) {
+  SplineFileHeader header;
+  std::ifstream inFile(path, std::ios::binary);
+  if (!inFile || !inFile.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      std::string(header.magic, 4) != "RCSP" || header.version != 1) {
+    std::cerr << "Error reading file\n";
+    return false;
+  }
+  inFile.close();
+
+  ControlPoints points;
+  if (!points.map(path, sizeof(header))) {
+    std::cerr << "Error reading file\n";
+    return false;
+  }
+
+  switch ((Spline::Type)header.type) {
+  case Spline::Type::Polyline:
+    model->setSpline(new Polyline());
+    break;
+  case Spline::Type::BSpline:
+    model->setSpline(new BSpline());
+    break;
+  case Spline::Type::CatmullRom:
+    model->setSpline(new CatmullRom());
+    break;
+  default:
+    std::cerr << "Error reading file\n";
+    return false;
+  }
+  model->getSpline()->setAntribute(points, header.loop != 0);
+  return true;
+}
+
 bool CurveProcessor::convertSplineType(Model *model, Spline::Type type) {
   Spline *spline = model->getSpline();
   if (spline->getType() == type || type == Spline::Type::Error)
     return false;
 
   bool loop = spline->getLoop();
-  std::vector<Eigen::Vector3f> points = spline->getPoints();
+  // Shared with the new spline, not copied
+  ControlPoints points = spline->getPoints();
 
   switch (type) {
   case Spline::Type::Polyline:
@@ -181,4 +580,5 @@ bool CurveProcessor::convertSplineType(Model *model, Spline::Type type) {
   } else {
     model->getSpline()->setLoop(loop);
   }
+  return true;
 }
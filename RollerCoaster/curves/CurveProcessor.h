@@ -1,19 +1,50 @@
 #pragma once
+#include <functional>
 #include <string>
 #include <vector>
 
 #include "../Model.h"
 #include "Spline.h"
+#include "TrackCache.h"
+#include "TrackSamples.h"
 
 class CurveProcessor {
 public:
   CurveProcessor() = delete;
 
-  static void samplePoints(Spline *spline, float segLen, std::vector<Eigen::Vector3f> &pos,
-                           std::vector<Eigen::Vector3f> &tangent,
-                           std::vector<Eigen::Vector3f> &normal, 
-                           std::vector<float> &curvature);
-  static void sampleCurvature(Spline *spline, float segLen, std::vector<float> &curvature);
+  // Batch: polynomial evaluation per sample with the SIMD kernels
+  // ForwardDifference: incremental walk over uniformly spaced samples
+  enum class SampleMode { Batch, ForwardDifference };
+
+  // Sample the whole track every segLen into samples in one walk over the
+  // curves, reusing its buffers
+  static void sampleTrack(Spline *spline, float segLen, TrackSamples &samples,
+                          SampleMode mode = SampleMode::Batch);
+  // Sample with the distance to the chords and the turn between samples
+  // bounded instead of a fixed spacing
+  static void sampleTrackAdaptive(Spline *spline, float chordal, float angle,
+                                  TrackSamples &samples);
+  // Receives one chunk of samples and the index of its first sample on the
+  // track, returns false to stop the stream
+  typedef std::function<bool(const TrackSamples &chunk, int first)> SampleSink;
+  // Sample the track every segLen like sampleTrack but hand the samples to
+  // sink at most chunkSize at a time, so memory does not grow with the
+  // track; returns the number of samples streamed
+  static int streamTrack(Spline *spline, float segLen, int chunkSize, const SampleSink &sink);
+  // Stream the samples of sampleTrackAdaptive the same way
+  static int streamTrackAdaptive(Spline *spline, float chordal, float angle, int chunkSize,
+                                 const SampleSink &sink);
+
+  // Tightest turn of one curve or of a whole spline
+  struct CurvatureExtremum {
+    int curve;        // Curve index, -1 if the spline has no curves
+    float u;          // Local parameter of the maximum
+    float curvature;  // Maximum curvature
+    float radius;     // Minimum radius 1 / curvature
+  };
+  // Analytic maximum curvature, per curve results are written to curves if given
+  static CurvatureExtremum findMaxCurvature(Spline *spline,
+                                            std::vector<CurvatureExtremum> *curves = nullptr);
 
   static Eigen::Vector3f parallelTransport(Eigen::Vector3f &u0, Eigen::Vector3f &t0,
                                            Eigen::Vector3f &t1);
@@ -21,6 +52,14 @@ public:
   // Save or Load Spline
   static void saveSpline(Spline *spline);
   static bool loadSpline(Model *model);
+  // Binary file whose control points are memory-mapped on load
+  static void saveSplineBinary(Spline *spline, const std::string &path = "spline.bin");
+  static bool loadSplineBinary(Model *model, const std::string &path = "spline.bin");
+
+  // Write the streamed samples as text, one position, unit tangent, normal
+  // and curvature per line, sampled with the settings of the tube
+  static bool exportTrack(Spline *spline, const TrackCache &settings,
+                          const std::string &path = "track.txt");
 
   static bool convertSplineType(Model *model, Spline::Type type);
 };
@@ -1,5 +1,4 @@
 #include "CurveRenderer.h"
-#include "CurveProcessor.h"
 
 #define M_PI 3.14159265358979323846
 
@@ -7,12 +6,14 @@ CurveRenderer::CurveRenderer() : VAO(0), VBO(0), NBO(0), EBO(0), CBO(0), indices
 
 CurveRenderer::~CurveRenderer() { release(); }
 
-void CurveRenderer::createVBO(Spline *spline, bool use_curvature_color, float radius) {
+void CurveRenderer::createVBO(Spline *spline, const TrackSamples &samples, bool use_curvature_color,
+                              float radius) {
   release();
   const int segments = 16;
-  std::vector<Eigen::Vector3f> _points, _tangents, _normals;
-  std::vector<float> _curvatures;
-  CurveProcessor::samplePoints(spline, 0.01f, _points, _tangents, _normals, _curvatures);
+  const std::vector<Eigen::Vector3f> &_points = samples.positions;
+  const std::vector<Eigen::Vector3f> &_tangents = samples.tangents;
+  const std::vector<Eigen::Vector3f> &_normals = samples.normals;
+  const std::vector<float> &_curvatures = samples.curvatures;
 
   // Must have 2 point or more
   if (_points.size() < 2) {
@@ -27,7 +28,7 @@ void CurveRenderer::createVBO(Spline *spline, bool use_curvature_color, float ra
   colors.reserve(_points.size() * 3);
   std::vector<unsigned int> indices;
   for (int i = 0; i < _points.size(); i++) {
-    Eigen::Vector3f &tangent = _tangents[i];
+    const Eigen::Vector3f &tangent = _tangents[i];
     //
     Eigen::Vector3f a = _normals[i];
     Eigen::Vector3f b = _tangents[i].cross(_normals[i]);
@@ -142,11 +143,10 @@ void CurveRenderer::draw() {
   glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, 0);
 }
 
-void CurveRenderer::setColor(Spline* spline, bool use_curvature_color)
+void CurveRenderer::setColor(const TrackSamples& samples, bool use_curvature_color)
 {
     const int segments = 16;
-    std::vector<float> _curvatures;
-    CurveProcessor::sampleCurvature(spline, 0.01f, _curvatures);
+    const std::vector<float>& _curvatures = samples.curvatures;
 
     // Must have 2 point or more
     if (_curvatures.size() < 2) {
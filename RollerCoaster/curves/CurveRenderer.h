@@ -2,6 +2,7 @@
 
 #include "../miscellaneous/tinycolormap.hpp"
 #include "Spline.h"
+#include "TrackSamples.h"
 #include <algorithm>
 #include <glad/glad.h>
 #include <vector>
@@ -13,10 +14,11 @@ public:
   ~CurveRenderer();
 
   // Init Pipe, Only Create pipe if the points is continuous
-  void createVBO(Spline *spline, bool use_curvature_color, float radius = 0.02f);
+  void createVBO(Spline *spline, const TrackSamples &samples, bool use_curvature_color,
+                 float radius = 0.02f);
   // Draw
   void draw();
-  void setColor(Spline* spline, bool use_curvature_color);
+  void setColor(const TrackSamples& samples, bool use_curvature_color);
 
 private:
   GLuint VAO, VBO, NBO, EBO, CBO;
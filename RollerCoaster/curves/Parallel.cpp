@@ -0,0 +1,185 @@
+#include "Parallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Elements per chunk below which a scan is not worth another thread
+static const int SCAN_GRAIN = 1 << 15;
+
+static int threadCount = 0;
+
+namespace {
+
+// Workers that sleep between ranges. One range runs at a time; the chunks of
+// a range are claimed through next by the workers and the calling thread
+struct Pool {
+  typedef void (*ChunkCall)(const void *context, int begin, int end);
+
+  std::vector<std::thread> workers;
+  std::mutex owner;               // Held by the thread whose range is running
+  std::mutex mutex;               // Guards the fields below
+  std::condition_variable wake;   // A new range or stop
+  std::condition_variable done;   // busy dropped to 0
+  unsigned int generation = 0;    // Counts the ranges handed out
+  int busy = 0;                   // Workers inside a range
+  bool stop = false;
+
+  ChunkCall call = nullptr;
+  const void *context = nullptr;
+  int n = 0, chunks = 0;
+  std::atomic<int> next{0};
+
+  ~Pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+      worker.join();
+  }
+
+  // Run chunks of the current range until none is left
+  void runChunks(ChunkCall f, const void *body, int size, int count) {
+    for (int k = next.fetch_add(1); k < count; k = next.fetch_add(1))
+      f(body, (int)((long long)size * k / count), (int)((long long)size * (k + 1) / count));
+  }
+
+  void work();
+};
+
+Pool pool;
+
+// Set on workers and on a thread while its range runs, a range started from
+// inside one runs inline instead of waiting for the pool it holds
+thread_local bool inRange = false;
+
+void Pool::work() {
+  inRange = true;
+  unsigned int seen = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    wake.wait(lock, [&]() { return stop || generation != seen; });
+    if (stop)
+      return;
+    seen = generation;
+    ChunkCall f = call;
+    const void *body = context;
+    int size = n, count = chunks;
+    busy++;
+    lock.unlock();
+    runChunks(f, body, size, count);
+    lock.lock();
+    if (--busy == 0)
+      done.notify_all();
+  }
+}
+
+}
+
+int Parallel::getThreadCount() {
+  if (threadCount > 0)
+    return threadCount;
+  static const int hardware = std::max(1, (int)std::thread::hardware_concurrency());
+  return hardware;
+}
+
+void Parallel::setThreadCount(int count) {
+  threadCount = std::max(0, count);
+}
+
+/******************************************************************************
+Run a range of at least two chunks on the pool
+
+Entry:
+  n       - number of indices
+  chunks  - number of chunks, at least 2
+  call    - runs the body of forRange on [begin, end)
+  context - the body
+
+The calling thread takes chunks as well. Workers are only started when the
+pool has fewer than chunks - 1 of them, so ranges of the same size or smaller
+do not allocate. A range started while another thread holds the pool, or from
+inside a range, runs on the calling thread
+******************************************************************************/
+void Parallel::run(int n, int chunks, ChunkCall call, const void *context) {
+  if (inRange || !pool.owner.try_lock()) {
+    call(context, 0, n);
+    return;
+  }
+  inRange = true;
+  while ((int)pool.workers.size() < chunks - 1)
+    pool.workers.emplace_back([]() { pool.work(); });
+
+  {
+    // Workers still leaving the previous range would claim chunks of this one
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.done.wait(lock, []() { return pool.busy == 0; });
+    pool.call = call;
+    pool.context = context;
+    pool.n = n;
+    pool.chunks = chunks;
+    pool.next = 0;
+    pool.generation++;
+  }
+  pool.wake.notify_all();
+  pool.runChunks(call, context, n, chunks);
+  {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.done.wait(lock, []() { return pool.busy == 0; });
+  }
+  inRange = false;
+  pool.owner.unlock();
+}
+
+/******************************************************************************
+Exclusive prefix sum of n floats
+
+Entry:
+  in - the values
+  n  - number of values
+
+Exit:
+  out - n + 1 prefix sums, out[0] = 0 and out[n] is the total
+
+Each chunk first sums its own values, the chunk totals are scanned in order
+and then added to the chunks in a second parallel pass
+******************************************************************************/
+void Parallel::exclusiveScan(const float *in, int n, double *out) {
+  out[0] = 0.0;
+  if (n <= 0)
+    return;
+  int chunks = std::max(1, std::min(getThreadCount(), n / SCAN_GRAIN));
+  if (chunks == 1) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+      sum += in[i];
+      out[i + 1] = sum;
+    }
+    return;
+  }
+  std::vector<double> offsets(chunks + 1, 0.0);
+  auto chunkBegin = [n, chunks](int k) { return (int)((long long)n * k / chunks); };
+
+  forRange(chunks, 1, [&](int first, int last) {
+    for (int k = first; k < last; k++) {
+      double sum = 0.0;
+      for (int i = chunkBegin(k); i < chunkBegin(k + 1); i++) {
+        sum += in[i];
+        out[i + 1] = sum;
+      }
+      offsets[k + 1] = sum;
+    }
+  });
+  for (int k = 1; k <= chunks; k++)
+    offsets[k] += offsets[k - 1];
+  forRange(chunks, 1, [&](int first, int last) {
+    for (int k = std::max(first, 1); k < last; k++) {
+      double offset = offsets[k];
+      for (int i = chunkBegin(k); i < chunkBegin(k + 1); i++)
+        out[i + 1] += offset;
+    }
+  });
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+
+// Splits index ranges over worker threads for work on very large splines.
+// Small ranges run on the calling thread, so callers need no threshold of their own.
+class Parallel {
+public:
+  Parallel() = delete;
+
+  // Threads used for a range, 0 restores the hardware concurrency
+  static int getThreadCount();
+  static void setThreadCount(int count);
+
+  // Call body(begin, end) on disjoint chunks covering [0, n), each chunk of
+  // at least grain indices; returns after every chunk is done. Neither path
+  // allocates: a range below two grains calls body inline, larger ones are
+  // handed to a pool of workers that is started once and kept
+  template <typename Body> static void forRange(int n, int grain, const Body &body);
+
+  // out[i] = in[0] + ... + in[i - 1] in double precision, out holds n + 1 values
+  static void exclusiveScan(const float *in, int n, double *out);
+
+private:
+  // Type-erased chunk call, context points to the body of forRange
+  typedef void (*ChunkCall)(const void *context, int begin, int end);
+  static void run(int n, int chunks, ChunkCall call, const void *context);
+};
+
+template <typename Body> void Parallel::forRange(int n, int grain, const Body &body) {
+  if (n <= 0)
+    return;
+  int chunks = std::min(getThreadCount(), n / std::max(grain, 1));
+  if (chunks <= 1) {
+    body(0, n);
+    return;
+  }
+  run(n, chunks,
+      [](const void *context, int begin, int end) {
+        (*static_cast<const Body *>(context))(begin, end);
+      },
+      &body);
+}
@@ -1,24 +1,28 @@
 #include "Polyline.h"
+#include <algorithm>
 
-void Polyline::build() 
+int Polyline::segmentCount() const
 {
-  Spline::build();
-  if (m_points.size() == 0) return;
+  int n = (int)m_points.size();
+  if (n == 0) return 0;
+  return m_loop ? n : n - 1;
+}
 
-  Eigen::Matrix4f matM;
-  matM << 0.0f, 0.0f, 0.0f, 0.0f,
-          0.0f, 0.0f, 0.0f, 0.0f,
-         -1.0f, 1.0f, 0.0f, 0.0f,
-          1.0f, 0.0f, 0.0f, 0.0f;
+Curve Polyline::buildSegment(int i) const
+{
+  int n = (int)m_points.size();
+  return Curve(m_points[i % n], m_points[(i + 1) % n]);
+}
 
+// Line i joins p(i) and p(i+1), so p(k) ends lines k - 1 and k
+void Polyline::affectedSegments(int k, int& first, int& count) const
+{
   int n = (int)m_points.size();
-  int j = m_loop ? n : n - 1;
-  for (int i = 0; i < j; i++) {
-      addCurve(
-      m_points[i % n],
-      m_points[(i + 1) % n],
-      Eigen::Vector3f::Zero(),
-      Eigen::Vector3f::Zero(),
-      matM);
+  if (m_loop) {
+    first = (k - 1 + n) % n;
+    count = std::min(2, n);
+    return;
   }
-}
\ No newline at end of file
+  first = std::max(k - 1, 0);
+  count = std::min(k, n - 2) - first + 1;
+}
@@ -5,7 +5,9 @@
 class Polyline : public Spline
 {
 protected:
-  void build() override;
+  int segmentCount() const override;
+  Curve buildSegment(int i) const override;
+  void affectedSegments(int k, int& first, int& count) const override;
 public:
   Polyline() : Spline(Type::Polyline) {}
 };
@@ -0,0 +1,112 @@
+#include "Polynomial.h"
+#include <algorithm>
+#include <cmath>
+
+double Polynomial::evaluate(const double *c, int degree, double x) {
+  double ret = c[degree];
+  for (int i = degree - 1; i >= 0; i--)
+    ret = ret * x + c[i];
+  return ret;
+}
+
+void Polynomial::derivative(const double *c, int degree, double *out) {
+  for (int i = 1; i <= degree; i++)
+    out[i - 1] = i * c[i];
+}
+
+/******************************************************************************
+Find the single root of c in a bracket where c is monotone
+
+Entry:
+  c      - coefficients of the polynomial
+  degree - degree of the polynomial
+  lo, hi - bracket with c(lo) and c(hi) of opposite sign
+  flo    - c(lo)
+
+Exit:
+  returns the root, Newton steps are used while they stay inside the bracket
+  and bisection otherwise
+******************************************************************************/
+static double refineRoot(const double *c, const double *dc, int degree, double lo, double hi,
+                         double flo) {
+  double x = 0.5 * (lo + hi);
+  for (int iter = 0; iter < 64; iter++) {
+    double fx = Polynomial::evaluate(c, degree, x);
+    if (fx == 0.0)
+      return x;
+    if ((fx < 0.0) == (flo < 0.0)) {
+      lo = x;
+      flo = fx;
+    } else {
+      hi = x;
+    }
+
+    double dfx = Polynomial::evaluate(dc, degree - 1, x);
+    double next = (dfx != 0.0) ? x - fx / dfx : lo;
+    if (next <= lo || next >= hi)
+      next = 0.5 * (lo + hi);
+    if (std::abs(next - x) <= 1e-14 * (1.0 + std::abs(x)) || hi - lo <= 1e-14)
+      return next;
+    x = next;
+  }
+  return x;
+}
+
+/******************************************************************************
+Isolate the real roots of c in [lo, hi]
+
+Entry:
+  c      - coefficients of the polynomial in ascending order of power
+  degree - degree of the polynomial, at most MAX_DEGREE
+  lo, hi - search interval
+
+Exit:
+  out    - roots in ascending order
+  returns the number of roots
+
+The roots of the derivative split [lo, hi] into intervals where c is
+monotone, so each interval holds at most one root and is refined on its own.
+Leading coefficients that vanish relative to the others are dropped first.
+******************************************************************************/
+int Polynomial::roots(const double *c, int degree, double lo, double hi, double *out) {
+  double scale = 0.0;
+  for (int i = 0; i <= degree; i++)
+    scale = std::max(scale, std::abs(c[i]));
+  while (degree > 0 && std::abs(c[degree]) <= 1e-12 * scale)
+    degree--;
+  if (degree <= 0)
+    return 0;
+  if (degree == 1) {
+    double x = -c[0] / c[1];
+    if (x < lo || x > hi)
+      return 0;
+    out[0] = x;
+    return 1;
+  }
+
+  double dc[MAX_DEGREE];
+  derivative(c, degree, dc);
+  double bounds[MAX_DEGREE + 1];
+  bounds[0] = lo;
+  int numBounds = 1 + roots(dc, degree - 1, lo, hi, bounds + 1);
+  bounds[numBounds++] = hi;
+
+  int n = 0;
+  double x0 = bounds[0];
+  double f0 = evaluate(c, degree, x0);
+  for (int i = 1; i < numBounds; i++) {
+    double x1 = bounds[i];
+    double f1 = evaluate(c, degree, x1);
+    if (f0 == 0.0) {
+      if (n == 0 || out[n - 1] != x0)
+        out[n++] = x0;
+    } else if ((f0 < 0.0) != (f1 < 0.0) && f1 != 0.0) {
+      out[n++] = refineRoot(c, dc, degree, x0, x1, f0);
+    }
+    x0 = x1;
+    f0 = f1;
+  }
+  if (f0 == 0.0 && (n == 0 || out[n - 1] != x0))
+    out[n++] = x0;
+  return n;
+}
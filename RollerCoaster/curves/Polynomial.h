@@ -0,0 +1,15 @@
+#pragma once
+
+// Real polynomials c[0] + c[1] x + ... + c[degree] x^degree in double precision
+class Polynomial {
+public:
+  Polynomial() = delete;
+
+  static const int MAX_DEGREE = 7;
+
+  static double evaluate(const double *c, int degree, double x);
+  // Coefficients of the derivative, degree - 1 of them are written to out
+  static void derivative(const double *c, int degree, double *out);
+  // Real roots in [lo, hi] in ascending order, returns the number of roots
+  static int roots(const double *c, int degree, double lo, double hi, double *out);
+};
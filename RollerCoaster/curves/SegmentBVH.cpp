@@ -0,0 +1,155 @@
+#include "SegmentBVH.h"
+#include <algorithm>
+#include <limits>
+
+void SegmentBVH::clear() {
+  nodes.clear();
+  items.clear();
+  leafOf.clear();
+}
+
+/******************************************************************************
+Build the hierarchy over the bounds of the curves
+
+Entry:
+  bounds - the tight bounds of the curves of the spline
+
+Nodes are stored depth first and split at the median center along the
+longest axis of their centers
+******************************************************************************/
+void SegmentBVH::build(const Bounds &bounds) {
+  clear();
+  int n = (int)bounds.size();
+  if (n == 0)
+    return;
+
+  std::vector<Eigen::Vector3f> centers(n);
+  items.resize(n);
+  leafOf.resize(n);
+  for (int i = 0; i < n; i++) {
+    centers[i] = bounds[i].center();
+    items[i] = i;
+  }
+  nodes.reserve(2 * (n / LEAF_SIZE + 1));
+  buildNode(bounds, centers, 0, n, -1);
+}
+
+int SegmentBVH::buildNode(const Bounds &bounds, const std::vector<Eigen::Vector3f> &centers,
+                          int first, int count, int parent) {
+  int index = (int)nodes.size();
+  nodes.push_back(Node{Eigen::AlignedBox3f(), parent, -1, first, 0});
+
+  if (count <= LEAF_SIZE) {
+    Eigen::AlignedBox3f box;
+    for (int i = first; i < first + count; i++) {
+      box.extend(bounds[items[i]]);
+      leafOf[items[i]] = index;
+    }
+    nodes[index].box = box;
+    nodes[index].count = count;
+    return index;
+  }
+
+  Eigen::AlignedBox3f spread;
+  for (int i = first; i < first + count; i++)
+    spread.extend(centers[items[i]]);
+  int axis;
+  spread.sizes().maxCoeff(&axis);
+  int half = count / 2;
+  std::nth_element(items.begin() + first, items.begin() + first + half,
+                   items.begin() + first + count,
+                   [&](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+  int left = buildNode(bounds, centers, first, half, index);
+  int right = buildNode(bounds, centers, first + half, count - half, index);
+  nodes[index].right = right;
+  nodes[index].box = nodes[left].box.merged(nodes[right].box);
+  return index;
+}
+
+/******************************************************************************
+Refresh the boxes of the leaves holding changed curves and of their ancestors
+
+Entry:
+  bounds  - the bounds of the curves, as many as when the hierarchy was built
+  changed - indices of curves whose bounds changed, may hold duplicates
+******************************************************************************/
+void SegmentBVH::refit(const Bounds &bounds, const std::vector<int> &changed) {
+  for (int i : changed) {
+    if (i < 0 || i >= size())
+      continue;
+    refitNode(bounds, leafOf[i]);
+  }
+}
+
+void SegmentBVH::refitNode(const Bounds &bounds, int node) {
+  const Node &leaf = nodes[node];
+  Eigen::AlignedBox3f box;
+  for (int i = leaf.first; i < leaf.first + leaf.count; i++)
+    box.extend(bounds[items[i]]);
+  nodes[node].box = box;
+
+  for (int j = nodes[node].parent; j >= 0; j = nodes[j].parent) {
+    Eigen::AlignedBox3f merged = nodes[j + 1].box.merged(nodes[nodes[j].right].box);
+    if (merged.min() == nodes[j].box.min() && merged.max() == nodes[j].box.max())
+      break;
+    nodes[j].box = merged;
+  }
+}
+
+/******************************************************************************
+Find the point of the curves closest to p
+
+Entry:
+  curves - the curves the hierarchy was built on
+  bounds - their bounds
+  p      - the point to project
+
+Exit:
+  curve, u  - the curve and parameter of the closest point
+  distance2 - the squared distance to it
+  returns false if there are no curves
+
+The nearer child is visited first, and subtrees whose box is farther away
+than the best point so far are skipped
+******************************************************************************/
+bool SegmentBVH::closestPoint(const std::vector<Curve> &curves, const Bounds &bounds,
+                              const Eigen::Vector3f &p, int &curve, float &u,
+                              float &distance2) const {
+  if (nodes.empty())
+    return false;
+
+  curve = -1;
+  distance2 = std::numeric_limits<float>::infinity();
+  int stack[64];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    int index = stack[--top];
+    const Node &node = nodes[index];
+    if (node.box.squaredExteriorDistance(p) >= distance2)
+      continue;
+
+    if (node.count > 0) {
+      for (int i = node.first; i < node.first + node.count; i++) {
+        if (bounds[items[i]].squaredExteriorDistance(p) >= distance2)
+          continue;
+        float t;
+        float d = curves[items[i]].closestPoint(p, t);
+        if (d < distance2) {
+          distance2 = d;
+          curve = items[i];
+          u = t;
+        }
+      }
+      continue;
+    }
+
+    int first = index + 1, second = node.right;
+    if (nodes[second].box.squaredExteriorDistance(p) < nodes[first].box.squaredExteriorDistance(p))
+      std::swap(first, second);
+    stack[top++] = second;
+    stack[top++] = first;
+  }
+  return curve >= 0;
+}
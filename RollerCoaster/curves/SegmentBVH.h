@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Curve.h"
+#include <Eigen/Dense>
+#include <vector>
+
+// Bounding volume hierarchy over the tight bounds of the curves of a spline,
+// for closest point queries on long tracks
+class SegmentBVH {
+public:
+  static const int LEAF_SIZE = 4;   // Most curves in a leaf
+  typedef std::vector<Eigen::AlignedBox3f> Bounds;
+
+private:
+  struct Node {
+    Eigen::AlignedBox3f box;
+    int parent;
+    int right;    // Second child of an inner node, the first one follows the node
+    int first;    // First entry of a leaf in items
+    int count;    // Curves of a leaf, 0 for inner nodes
+  };
+
+  std::vector<Node> nodes;
+  std::vector<int> items;     // Curve indices, grouped by leaf
+  std::vector<int> leafOf;    // Leaf node of every curve
+
+  int buildNode(const Bounds &bounds, const std::vector<Eigen::Vector3f> &centers, int first,
+                int count, int parent);
+  void refitNode(const Bounds &bounds, int node);
+
+public:
+  // The bounds of the curves are kept by the spline, next to its curves
+  void build(const Bounds &bounds);
+  // Update the boxes above curves whose bounds changed, the tree keeps its shape
+  void refit(const Bounds &bounds, const std::vector<int> &changed);
+  void clear();
+
+  // Closest point of all curves to p, returns false if there are none
+  bool closestPoint(const std::vector<Curve> &curves, const Bounds &bounds,
+                    const Eigen::Vector3f &p, int &curve, float &u, float &distance2) const;
+
+  inline int size() const { return (int)leafOf.size(); }
+};
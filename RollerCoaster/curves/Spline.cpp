@@ -1,4 +1,20 @@
 #include "Spline.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <limits>
+
+// Segments appended at once from which the build is split over threads
+static const int PARALLEL_SEGMENTS = 4096;
+
+// Source of epochs, shared so that no two spline states get the same one,
+// splines built on worker threads take theirs from it too
+static std::atomic<unsigned int> epochCounter(0);
+
+Spline::Spline(Type type) : m_loop(false), m_type(type), arcLength(0.0f),
+    lengthTolerance(1e-4f), lengthEvaluations(0), epoch(epochCounter.fetch_add(1) + 1) {}
 
 /******************************************************************************
 Build the spline with the given control points
@@ -6,9 +22,334 @@ Build the spline with the given control points
 void Spline::build()
 {
     m_curves.clear();
+    arcTables.clear();
+    arcTableStart.clear();
+    curveBounds.clear();
     preLength.clear();
-    preLength.push_back(0.0f);
+    curveChanges.markAll();
     arcLength = 0.0f;
+    lengthEvaluations = 0;
+
+    appendSegments(0);
+}
+
+/******************************************************************************
+Rebuild the segments from first to the end, the ones before are kept
+
+Entry:
+  first - first segment whose control points changed or moved
+******************************************************************************/
+void Spline::rebuildFrom(int first)
+{
+    // Loops wrap around to the first segments, so start over
+    if (m_loop || first <= 0 || first > (int)m_curves.size() || first > segmentCount()) {
+        build();
+        return;
+    }
+
+    if (first < (int)m_curves.size()) {
+        arcTables.resize(arcTableStart[first]);
+        arcTableStart.resize(first);
+        curveBounds.resize(first);
+        m_curves.erase(m_curves.begin() + first, m_curves.end());
+    }
+    curveChanges.markFrom(first);
+    preLength.resize(first);
+    arcLength = (float)preLength.total();
+    appendSegments(first);
+}
+
+/******************************************************************************
+Build the segments from first to segmentCount() and append them
+
+Entry:
+  first - number of segments already built
+
+Segments only read the control points, so long runs are built and measured
+on several threads; the lengths then go into the index with a parallel scan
+******************************************************************************/
+void Spline::appendSegments(int first)
+{
+    int n = segmentCount();
+    int count = n - first;
+    if (count < PARALLEL_SEGMENTS) {
+        m_curves.reserve(n);
+        arcTableStart.reserve(n);
+        curveBounds.reserve(n);
+        preLength.reserve(n);
+        for (int i = first; i < n; i++) {
+            m_curves.push_back(buildSegment(i));
+            appendFeatures();
+        }
+        return;
+    }
+
+    m_curves.resize(n);
+    curveChanges.markFrom(first);
+    Parallel::forRange(count, PARALLEL_SEGMENTS / 4, [&](int begin, int end) {
+        for (int k = begin; k < end; k++)
+            m_curves[first + k] = buildSegment(first + k);
+    });
+    // Only the curved segments get a table
+    arcTableStart.resize(n);
+    int tables = (int)arcTables.size();
+    for (int i = first; i < n; i++) {
+        arcTableStart[i] = tables;
+        tables += m_curves[i].getDegree() > 1 ? 1 : 0;
+    }
+    arcTables.resize(tables);
+    curveBounds.resize(n);
+
+    std::vector<float> lengths(count);
+    std::atomic<int> evaluations(0);
+    Parallel::forRange(count, PARALLEL_SEGMENTS / 4, [&](int begin, int end) {
+        int local = 0;
+        for (int k = begin; k < end; k++) {
+            local += calculateFeatures(first + k);
+            lengths[k] = m_curves[first + k].getLength();
+        }
+        evaluations += local;
+    });
+    lengthEvaluations += evaluations;
+    preLength.append(lengths.data(), count);
+    arcLength = (float)preLength.total();
+}
+
+/******************************************************************************
+Rebuild single segments in place
+
+Entry:
+  segments - indices of the segments, may hold duplicates
+******************************************************************************/
+void Spline::rebuildSegments(std::vector<int>& segments)
+{
+    if (segmentCount() != (int)m_curves.size()) {
+        build();
+        return;
+    }
+
+    std::sort(segments.begin(), segments.end());
+    segments.erase(std::unique(segments.begin(), segments.end()), segments.end());
+    for (int i : segments) {
+        bool wasCurved = m_curves[i].getDegree() > 1;
+        m_curves[i] = buildSegment(i);
+        bool curved = m_curves[i].getDegree() > 1;
+        if (curved != wasCurved) {
+            // The segment became straight or curved, the later tables move by one
+            if (curved)
+                arcTables.insert(arcTables.begin() + arcTableStart[i], ArcLengthTable());
+            else
+                arcTables.erase(arcTables.begin() + arcTableStart[i]);
+            for (int j = i + 1; j < (int)m_curves.size(); j++)
+                arcTableStart[j] += curved ? 1 : -1;
+        }
+        curveChanges.mark(i);
+        lengthEvaluations += calculateFeatures(i);
+        preLength.update(i, m_curves[i].getLength());
+    }
+    arcLength = (float)preLength.total();
+}
+
+/******************************************************************************
+Start an edit, nested edits are committed with the outermost one
+******************************************************************************/
+void Spline::beginEdit()
+{
+    editDepth++;
+    editMarks.push_back(editUndo.size());
+}
+
+/******************************************************************************
+Finish an edit and rebuild what the changes since beginEdit touched
+
+Exit:
+  returns true if the spline was rebuilt
+******************************************************************************/
+bool Spline::commitEdit()
+{
+    if (!editMarks.empty()) editMarks.pop_back();
+    if (editDepth > 0 && --editDepth > 0) return false;
+    editUndo.clear();
+    replacedPoints.clear();
+
+    bool changed = editFull || editFrom >= 0 || !editSegments.empty();
+    if (editFull || editFrom == 0) {
+        build();
+    }
+    else if (changed) {
+        lengthEvaluations = 0;
+        // Segments in front of the rebuilt tail kept their index
+        if (editFrom > 0) {
+            editSegments.erase(std::remove_if(editSegments.begin(), editSegments.end(),
+                [this](int i) { return i >= editFrom; }), editSegments.end());
+            rebuildFrom(editFrom);
+        }
+        if (!editSegments.empty())
+            rebuildSegments(editSegments);
+    }
+
+    editFull = false;
+    editFrom = -1;
+    editSegments.clear();
+    if (changed)
+        epoch = epochCounter.fetch_add(1) + 1;
+    if (changed && snapshotsEnabled)
+        publish();
+    if (changed && bvhValid) {
+        // Curves rebuilt in place keep the shape of the tree
+        if (curveChanges.from == INT_MAX && m_bvh.size() == (int)m_curves.size())
+            m_bvh.refit(curveBounds, curveChanges.single);
+        else
+            bvhValid = false;
+    }
+    pointChanges.clear();
+    curveChanges.clear();
+    return changed;
+}
+
+/******************************************************************************
+Finish an edit by undoing its changes, latest first
+
+The segments an inner edit marked stay marked for the outer one: the undo
+changes the same points back, and a point added or removed marked the whole
+tail. The outermost one restores the points the curves were built from, so
+nothing is rebuilt
+******************************************************************************/
+void Spline::rollbackEdit()
+{
+    if (editDepth == 0) return;
+    size_t mark = editMarks.back();
+    editMarks.pop_back();
+    for (; editUndo.size() > mark; editUndo.pop_back()) {
+        const EditUndo& undo = editUndo.back();
+        switch (undo.kind) {
+        case EditUndo::SET:
+            m_points.set(undo.index, undo.point);
+            break;
+        case EditUndo::APPEND:
+            m_points.erase(m_points.size() - 1);
+            break;
+        case EditUndo::ERASE:
+            m_points.insert(undo.index, undo.point);
+            selectedIdx = undo.index;
+            break;
+        case EditUndo::POINTS:
+            m_points = replacedPoints[undo.index];
+            m_loop = undo.loop;
+            replacedPoints.pop_back();
+            break;
+        case EditUndo::LOOP:
+            m_loop = undo.loop;
+            break;
+        case EditUndo::TOLERANCE:
+            lengthTolerance = undo.tolerance;
+            break;
+        }
+    }
+
+    if (--editDepth > 0) return;
+    editFull = false;
+    editFrom = -1;
+    editSegments.clear();
+    editUndo.clear();
+    replacedPoints.clear();
+    pointChanges.clear();
+    curveChanges.clear();
+}
+
+/******************************************************************************
+Keep what undoes a change that is about to be made
+
+Entry:
+  kind  - the change
+  index - point that is set or erased
+
+Only changes inside an outer edit can be rolled back, the others are
+committed by the call that makes them
+******************************************************************************/
+void Spline::recordUndo(EditUndo::Kind kind, int index)
+{
+    if (editDepth <= 1) return;
+    EditUndo undo = { kind, index, Eigen::Vector3f::Zero(), m_loop, lengthTolerance };
+    if (kind == EditUndo::SET || kind == EditUndo::ERASE)
+        undo.point = m_points[index];
+    if (kind == EditUndo::POINTS) {
+        undo.index = (int)replacedPoints.size();
+        replacedPoints.push_back(m_points);
+    }
+    editUndo.push_back(undo);
+}
+
+/******************************************************************************
+Publish a snapshot of the current state, sharing the chunks that did not
+change since the last one
+******************************************************************************/
+void Spline::publish()
+{
+    std::shared_ptr<const SplineSnapshot> previous = std::atomic_load(&published);
+    std::atomic_store(&published, SplineSnapshot::create(m_points, m_curves, arcTables,
+        arcTableStart, m_loop, epoch, previous.get(), pointChanges, curveChanges));
+}
+
+std::shared_ptr<const SplineSnapshot> Spline::getSnapshot() const
+{
+    return std::atomic_load(&published);
+}
+
+/******************************************************************************
+Start or stop publishing snapshots on every committed edit
+******************************************************************************/
+void Spline::setSnapshots(bool enabled)
+{
+    if (enabled && !snapshotsEnabled) {
+        pointChanges.markAll();
+        curveChanges.markAll();
+        snapshotsEnabled = true;
+        publish();
+        pointChanges.clear();
+        curveChanges.clear();
+    }
+    else if (!enabled && snapshotsEnabled) {
+        snapshotsEnabled = false;
+        std::atomic_store(&published, std::shared_ptr<const SplineSnapshot>());
+    }
+}
+
+/******************************************************************************
+Record that segments from first to the end have to be rebuilt
+******************************************************************************/
+void Spline::markFrom(int first)
+{
+    // Loops wrap around to the first segments
+    if (m_loop) {
+        markFull();
+        return;
+    }
+    editFrom = (editFrom < 0) ? first : std::min(editFrom, first);
+}
+
+/******************************************************************************
+Record that control point k moved
+******************************************************************************/
+void Spline::markPoint(int k)
+{
+    int n = segmentCount();
+    if (n == 0) {
+        markFull();
+        return;
+    }
+    int first, count;
+    affectedSegments(k, first, count);
+    for (int j = 0; j < count; j++)
+        editSegments.push_back((first + j) % n);
+}
+
+/******************************************************************************
+Record that every segment has to be rebuilt
+******************************************************************************/
+void Spline::markFull()
+{
+    editFull = true;
 }
 
 /******************************************************************************
@@ -32,8 +373,14 @@ Entry:
 ******************************************************************************/
 void Spline::addPoint(Eigen::Vector3f& p)
 {
+    beginEdit();
+    recordUndo(EditUndo::APPEND);
     m_points.push_back(p);
-    build();
+    pointChanges.markFrom((int)m_points.size() - 1);
+    int first, count;
+    affectedSegments((int)m_points.size() - 1, first, count);
+    markFrom(first);
+    commitEdit();
 }
 
 /******************************************************************************
@@ -42,27 +389,47 @@ Remove the last control point
 void Spline::removePoint() {
   if (selectedIdx < 0 || selectedIdx >= m_points.size())
     return;
-  m_points.erase(m_points.begin() + selectedIdx);
+  beginEdit();
+  recordUndo(EditUndo::ERASE, selectedIdx);
+  m_points.erase(selectedIdx);
+  pointChanges.markFrom(selectedIdx);
+  int first, count;
+  affectedSegments(selectedIdx, first, count);
+  markFrom(first);
   selectedIdx = -1;
-  build();
+  commitEdit();
 }
 
 /******************************************************************************
-Add a polynoimal curve to this splines
+Calculate the length of the last added curve and extend the prefix
+******************************************************************************/
+void Spline::appendFeatures()
+{
+    int i = (int)m_curves.size() - 1;
+    arcTableStart.push_back((int)arcTables.size());
+    if (m_curves[i].getDegree() > 1)
+        arcTables.emplace_back();
+    curveBounds.emplace_back();
+    lengthEvaluations += calculateFeatures(i);
+    curveChanges.markFrom(i);
+    preLength.push_back(m_curves.back().getLength());
+    arcLength = (float)preLength.total();
+}
+
+/******************************************************************************
+Calculate the length of curve i, fill its arc-length table and its bounds
 
 Entry:
-  a - the first vector (e.g., p0)
-  b - the second vector (e.g., p1)
-  c - the thrid vector (e.g., p2)
-  d - the forth vector (e.g., p3)
-  M - the matrix to compute coefficients 
+  i - the curve, its bounds and, if it is curved, its table slot exist
+
+Exit:
+  returns the number of ||C'(u)|| evaluations spent
 ******************************************************************************/
-void Spline::addCurve(const Eigen::Vector3f& a, const Eigen::Vector3f& b, const Eigen::Vector3f& c, const Eigen::Vector3f& d, Eigen::Matrix4f& M)
+int Spline::calculateFeatures(int i)
 {
-    m_curves.emplace_back(a, b, c, d, M);
-    m_curves.back().calculateFeatures();
-    arcLength += m_curves.back().getLength();
-    preLength.push_back(arcLength);
+    ArcLengthTable* table = m_curves[i].getDegree() > 1 ? &arcTables[arcTableStart[i]] : nullptr;
+    curveBounds[i] = m_curves[i].getBounds();
+    return m_curves[i].calculateFeatures(lengthTolerance, table);
 }
 
 /******************************************************************************
@@ -82,23 +449,15 @@ Reparameterize t to (i, u) such that the curve is unit speed
 ******************************************************************************/
 std::pair<int, float> Spline::parameterizeUnitSpeed(float s)
 {
-    /*
-    TODO: Implement the function to reparameterize.
-    Hint: We store the arc-length of each curve in preLength (s0-s1-s2-...-sn)
-          Therefore, you can search s is in which interval of perLength and interpolate u
-    */
     if (s <= 0.0f) return { 0, 0.0f };
-    if (s >= preLength.back()) return { static_cast<int>(preLength.size()) - 1, 1.0f };
+    if (s >= arcLength) return { static_cast<int>(m_curves.size()) - 1, 1.0f };
 
-    // Use binary search to find the segment
-    auto it = std::lower_bound(preLength.begin(), preLength.end(), s);
-    int i = std::distance(preLength.begin(), it) - 1;
+    // Descend the length index to find the segment
+    double rest;
+    int i = preLength.find(s, rest);
 
-    float segmentStart = preLength[i];
-    float segmentEnd = preLength[i + 1];
-    float u = (s - segmentStart) / (segmentEnd - segmentStart);
-
-    return { i, u };
+    // Invert the arc-length inside the segment with its table
+    return { i, getU(i, (float)rest) };
 }
 
 Eigen::Vector3f Spline::getPosition(float t, bool flagUS) {
@@ -155,6 +514,231 @@ double Spline::getCurvatureS(float s)
     return m_curves[u.first].getCurvature(u.second);
 }
 
+/******************************************************************************
+Evaluate the Frenet frames at n parameters
+
+Entry:
+  t      - parameters, arc-length if flagUS
+  n      - number of parameters
+  flagUS - unit speed parameterization
+
+Exit:
+  frames - frame, curvature and torsion per parameter
+
+Consecutive parameters on the same curve are evaluated in one batch
+******************************************************************************/
+void Spline::getFrenetFrames(const float* t, int n, FrenetFrame* frames, bool flagUS)
+{
+    if (m_curves.empty()) return;
+    const int BATCH = 64;
+    float u[BATCH];
+    int start = 0, count = 0, curve = -1;
+    for (int i = 0; i < n; i++) {
+        std::pair<int, float> p = flagUS ? parameterizeUnitSpeed(t[i]) : parameterize(t[i]);
+        if (count > 0 && (p.first != curve || count == BATCH)) {
+            m_curves[curve].getFrenetFrames(u, count, frames + start);
+            start = i;
+            count = 0;
+        }
+        curve = p.first;
+        u[count++] = p.second;
+    }
+    if (count > 0)
+        m_curves[curve].getFrenetFrames(u, count, frames + start);
+}
+
+/******************************************************************************
+Find the point of the spline closest to p
+
+Entry:
+  p - the point to project
+
+Exit:
+  returns the curve, u and arc-length of the closest point and its distance,
+  curve is -1 if there is none
+******************************************************************************/
+SplineProjection Spline::closestPoint(const Eigen::Vector3f& p)
+{
+    SplineProjection ret = { -1, 0.0f, 0.0f, Eigen::Vector3f::Zero(), 0.0f };
+    if (m_curves.empty()) return ret;
+    if (!bvhValid || m_bvh.size() != (int)m_curves.size()) {
+        m_bvh.build(curveBounds);
+        bvhValid = true;
+    }
+
+    float distance2;
+    if (!m_bvh.closestPoint(m_curves, curveBounds, p, ret.curve, ret.u, distance2)) {
+        // Nothing was closer than infinity, e.g. p is not finite; scan the
+        // curves so a finite answer is not missed
+        distance2 = std::numeric_limits<float>::infinity();
+        for (int i = 0; i < (int)m_curves.size(); i++) {
+            float u;
+            float d = m_curves[i].closestPoint(p, u);
+            if (d < distance2) {
+                distance2 = d;
+                ret.curve = i;
+                ret.u = u;
+            }
+        }
+        if (ret.curve < 0) return ret;
+    }
+    const Curve& curve = m_curves[ret.curve];
+    ret.s = (float)(preLength.prefix(ret.curve) + curve.getS(ret.u));
+    ret.position = curve.getPosition(ret.u);
+    ret.distance = std::sqrt(distance2);
+    return ret;
+}
+
+/******************************************************************************
+Sort n parameters with a radix sort on their bits
+
+Entry:
+  t     - parameters
+  n     - number of parameters
+
+Exit:
+  order - indices of t in ascending order of t
+******************************************************************************/
+static void sortQueries(const float* t, int n, std::vector<int>& order)
+{
+    // Flip the bits so the unsigned order of the keys is the order of the floats
+    std::vector<unsigned int> keys(n), keys2(n);
+    std::vector<int> order2(n);
+    order.resize(n);
+    for (int i = 0; i < n; i++) {
+        unsigned int bits;
+        std::memcpy(&bits, &t[i], sizeof(bits));
+        keys[i] = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        order[i] = i;
+    }
+
+    const int RADIX_BITS = 11, RADIX = 1 << RADIX_BITS;
+    std::vector<int> offset(RADIX + 1);
+    for (int shift = 0; shift < 32; shift += RADIX_BITS) {
+        std::fill(offset.begin(), offset.end(), 0);
+        for (int i = 0; i < n; i++)
+            offset[((keys[i] >> shift) & (RADIX - 1)) + 1]++;
+        for (int d = 0; d < RADIX; d++)
+            offset[d + 1] += offset[d];
+        for (int i = 0; i < n; i++) {
+            int j = offset[(keys[i] >> shift) & (RADIX - 1)]++;
+            keys2[j] = keys[i];
+            order2[j] = order[i];
+        }
+        keys.swap(keys2);
+        order.swap(order2);
+    }
+}
+
+/******************************************************************************
+Evaluate the spline at many parameters
+
+Entry:
+  t          - parameters, arc-length if flagUS
+  n          - number of parameters
+  flagUS     - unit speed parameterization
+  sorted     - t is ascending, so arc-lengths need no sorting
+
+Exit:
+  positions  - C at t[i], may be null
+  tangents   - C' at t[i], may be null
+  curvatures - curvature at t[i], may be null
+
+The queries are visited in ascending order, so the arc-length search is a
+single forward walk over the curves, and the parameters that land on the
+same curve go to the batch kernels together
+******************************************************************************/
+void Spline::evaluateBatch(const float* t, int n, bool flagUS, Eigen::Vector3f* positions,
+                           Eigen::Vector3f* tangents, float* curvatures, bool sorted)
+{
+    if (n <= 0) return;
+    int numCurves = (int)m_curves.size();
+    if (numCurves == 0) {
+        for (int i = 0; i < n; i++) {
+            if (positions) positions[i].setZero();
+            if (tangents) tangents[i].setZero();
+            if (curvatures) curvatures[i] = 0.0f;
+        }
+        return;
+    }
+
+    // Global parameters map to curves in O(1) and need no order, arc-lengths
+    // are sorted so the search becomes a walk
+    std::vector<int> order;
+    bool inPlace = sorted || !flagUS;
+    if (!inPlace)
+        sortQueries(t, n, order);
+
+    const int BATCH = 256;
+    float u[BATCH];
+    int slot[BATCH];
+    Eigen::Vector3f pos[BATCH], tan[BATCH];
+    float curv[BATCH];
+    int count = 0, current = -1;
+    // Evaluate the pending parameters of curve current, in place when sorted
+    auto flush = [&]() {
+        if (count == 0) return;
+        const Curve& c = m_curves[current];
+        if (inPlace) {
+            int first = slot[0];
+            c.evaluate(u, count, positions ? positions + first : nullptr,
+                       tangents ? tangents + first : nullptr,
+                       curvatures ? curvatures + first : nullptr);
+        }
+        else {
+            c.evaluate(u, count, positions ? pos : nullptr, tangents ? tan : nullptr,
+                       curvatures ? curv : nullptr);
+            for (int j = 0; j < count; j++) {
+                if (positions) positions[slot[j]] = pos[j];
+                if (tangents) tangents[slot[j]] = tan[j];
+                if (curvatures) curvatures[slot[j]] = curv[j];
+            }
+        }
+        count = 0;
+    };
+
+    int curve = 0;
+    double start = 0.0, end = preLength.length(0);
+    for (int k = 0; k < n; k++) {
+        int q = inPlace ? k : order[k];
+        std::pair<int, float> p;
+        if (!flagUS) {
+            p = parameterize(t[q]);
+        }
+        else if (t[q] <= 0.0f) {
+            p = { 0, 0.0f };
+        }
+        else if (t[q] >= arcLength) {
+            p = { numCurves - 1, 1.0f };
+        }
+        else {
+            // Walk forward, search the index when the next query is far ahead
+            int step = 0;
+            while (t[q] >= end && curve < numCurves - 1 && step < 8) {
+                start = end;
+                curve++;
+                end += preLength.length(curve);
+                step++;
+            }
+            if (t[q] >= end && curve < numCurves - 1) {
+                double rest;
+                curve = preLength.find(t[q], rest);
+                start = t[q] - rest;
+                end = start + preLength.length(curve);
+            }
+            p = { curve, getU(curve, (float)(t[q] - start)) };
+        }
+
+        if (count == BATCH || (count > 0 && p.first != current))
+            flush();
+        current = p.first;
+        u[count] = p.second;
+        slot[count] = q;
+        count++;
+    }
+    flush();
+}
+
 Eigen::Vector3f Spline::getSelectedPoint() const
 {
     return  isSelectedPoint() ? m_points[selectedIdx] : Eigen::Vector3f::Zero();
@@ -162,8 +746,12 @@ Eigen::Vector3f Spline::getSelectedPoint() const
 
 void Spline::setSelectedPoint(Eigen::Vector3f& p)
 {
-    m_points[selectedIdx] = p;
-    build();
+    beginEdit();
+    recordUndo(EditUndo::SET, selectedIdx);
+    m_points.set(selectedIdx, p);
+    pointChanges.mark(selectedIdx);
+    markPoint(selectedIdx);
+    commitEdit();
 }
 
 bool Spline::isSelectedPoint() const
@@ -172,21 +760,41 @@ bool Spline::isSelectedPoint() const
 }
 
 
-void Spline::setAntribute(std::vector<Eigen::Vector3f>& points, bool loop)
+void Spline::setAntribute(const ControlPoints& points, bool loop)
 {
+    beginEdit();
+    recordUndo(EditUndo::POINTS);
     m_loop = loop;
     m_points = points;
-    build();
+    pointChanges.markAll();
+    markFull();
+    commitEdit();
 }
 
 void Spline::setLoop(bool loop)
 {
+    beginEdit();
+    recordUndo(EditUndo::LOOP);
     m_loop = loop;
-    build();
+    markFull();
+    commitEdit();
+}
+
+void Spline::setLengthTolerance(float tolerance)
+{
+    beginEdit();
+    recordUndo(EditUndo::TOLERANCE);
+    lengthTolerance = tolerance;
+    markFull();
+    commitEdit();
 }
 
-void Spline::setPoints(std::vector<Eigen::Vector3f>& points)
+void Spline::setPoints(const ControlPoints& points)
 {
+    beginEdit();
+    recordUndo(EditUndo::POINTS);
     m_points = points;
-    build();
+    pointChanges.markAll();
+    markFull();
+    commitEdit();
 }
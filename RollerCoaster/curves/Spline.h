@@ -1,9 +1,24 @@
 #pragma once
 
+#include "ArcLengthIndex.h"
+#include "ControlPoints.h"
 #include "Curve.h"
+#include "SegmentBVH.h"
+#include "SplineSnapshot.h"
 #include <Eigen/Dense>
+#include <memory>
 #include <vector>
 
+// Closest point of a spline to a query point
+struct SplineProjection
+{
+  int curve;                  // Curve index, -1 if the spline has no curves
+  float u;                    // Local parameter on the curve
+  float s;                    // Arc-length from the start of the spline
+  Eigen::Vector3f position;   // The closest point
+  float distance;             // Distance from the query point
+};
+
 class Spline
 {
 public:
@@ -15,33 +30,87 @@ public:
     };
 
 protected:
-  std::vector<Eigen::Vector3f> m_points;  // Control Points
+  ControlPoints m_points;                 // Control Points, shared by copies
   std::vector<Curve> m_curves;            // Curves
+  std::vector<ArcLengthTable> arcTables;  // Tables of the curved segments, in curve order
+  std::vector<int> arcTableStart;         // Curved segments before each curve
+  std::vector<Eigen::AlignedBox3f> curveBounds;   // Tight bounds of each curve
   float arcLength;
-  std::vector<float> preLength;           // Prefix of Curve Length
+  ArcLengthIndex preLength;               // Prefix of Curve Length
+  float lengthTolerance;                  // Arc-length Error per Curve
+  int lengthEvaluations;                  // Speed Evaluations of Last Build
 
   bool m_loop;    // Loop Spline
   Type m_type;            // Spline Type
   int selectedIdx = -1;   // Selected Index
 
+  // Pending changes of the open edit, applied by commitEdit
+  int editDepth = 0;              // Nested beginEdit calls
+  bool editFull = false;          // Everything has to be rebuilt
+  int editFrom = -1;              // Rebuild from this segment to the end
+  std::vector<int> editSegments;  // Single segments to rebuild
+  unsigned int epoch;             // Changes on every rebuild, unique across splines
+
+  // A change made inside an outer edit, enough to undo it
+  struct EditUndo {
+    enum Kind { SET, APPEND, ERASE, POINTS, LOOP, TOLERANCE } kind;
+    int index;                // Point of SET and ERASE, replacedPoints entry of POINTS
+    Eigen::Vector3f point;    // Point before SET, the erased point
+    bool loop;                // Loop before LOOP and POINTS
+    float tolerance;          // Tolerance before TOLERANCE
+  };
+  std::vector<EditUndo> editUndo;         // Changes that rollbackEdit can still undo
+  std::vector<ControlPoints> replacedPoints;  // Points replaced as a whole, shared
+  std::vector<size_t> editMarks;          // Size of editUndo at each open beginEdit
+
+  // Last published snapshot and what changed since, if snapshotsEnabled
+  std::shared_ptr<const SplineSnapshot> published;
+  bool snapshotsEnabled = false;
+  SnapshotChanges pointChanges;
+  SnapshotChanges curveChanges;
+
+  // Hierarchy over curveBounds, built by the first query after a structural
+  // change and refit after in-place edits
+  SegmentBVH m_bvh;
+  bool bvhValid = false;
+
 
 protected:
   virtual void build();
+  void appendFeatures();
+  int calculateFeatures(int i);
+  void appendSegments(int first);
+  void rebuildFrom(int first);
+  void rebuildSegments(std::vector<int>& segments);
+  void markFrom(int first);
+  void markPoint(int k);
+  void markFull();
+  void recordUndo(EditUndo::Kind kind, int index = 0);
+  void publish();
+
+  // Segments of the spline type for the current control points
+  virtual int segmentCount() const = 0;
+  virtual Curve buildSegment(int i) const = 0;
+  // Segments first, first + 1, ..., first + count - 1 (mod segmentCount for
+  // loops) depend on control point k
+  virtual void affectedSegments(int k, int& first, int& count) const = 0;
 
 public:
-  Spline(Type type) : m_loop(false), m_type(type), arcLength(0.0f){}
+  Spline(Type type);
+
+  // Edits between beginEdit and commitEdit are rebuilt once on commit,
+  // commitEdit returns true if the spline changed. rollbackEdit ends an edit
+  // by undoing its changes instead; once the outermost edit is rolled back
+  // nothing is rebuilt
+  void beginEdit();
+  bool commitEdit();
+  void rollbackEdit();
+  inline bool isEditing() const { return editDepth > 0; }
 
   // Control Points
   virtual void addPoint();
   virtual void addPoint(Eigen::Vector3f& p);
   virtual void removePoint();
-  virtual void addCurve(
-      const Eigen::Vector3f& a,
-      const Eigen::Vector3f& b,
-      const Eigen::Vector3f& c,
-      const Eigen::Vector3f& d,
-      Eigen::Matrix4f& M
-  );
 
   // Get Position in specific Time
   Eigen::Vector3f getPosition(float t, bool flagUS);
@@ -57,13 +126,39 @@ public:
   Eigen::Vector3f getPositionS(float s);
   Eigen::Vector3f getTangentS(float s);
   double getCurvatureS(float s);
+  // Frenet frames at n parameters t, arc-length if flagUS
+  void getFrenetFrames(const float* t, int n, FrenetFrame* frames, bool flagUS);
+  // Evaluate n parameters t in one walk over the curves, outputs are in query
+  // order and may be null; sorted skips sorting arc-lengths that are ascending
+  void evaluateBatch(const float* t, int n, bool flagUS, Eigen::Vector3f* positions,
+                     Eigen::Vector3f* tangents, float* curvatures, bool sorted = false);
+  // Closest point on the spline to p
+  SplineProjection closestPoint(const Eigen::Vector3f& p);
 
   // Other Getter
   inline int getNumCurves() { return (int)m_curves.size(); }
   inline std::vector<Curve>& getCurves() { return m_curves; }
-  inline std::vector<Eigen::Vector3f>& getPoints() { return m_points; }
+  // Arc-length table of curve i, null for a line
+  inline const ArcLengthTable* getArcTable(int i) const {
+    return m_curves[i].getDegree() > 1 ? &arcTables[arcTableStart[i]] : nullptr;
+  }
+  // u on curve i at arc-length s from its start
+  inline float getU(int i, float s) const { return m_curves[i].getU(s, getArcTable(i)); }
+  inline const Eigen::AlignedBox3f& getCurveBounds(int i) const { return curveBounds[i]; }
+  inline const ControlPoints& getPoints() const { return m_points; }
   inline Type getType() { return m_type; }
   inline bool getLoop() const { return m_loop; }
+  inline float getArcLength() const { return arcLength; }
+  inline float getLengthTolerance() const { return lengthTolerance; }
+  inline int getLengthEvaluations() const { return lengthEvaluations; }
+  inline const ArcLengthIndex& getLengthIndex() const { return preLength; }
+  inline unsigned int getEpoch() const { return epoch; }
+
+  // Immutable copy of the last committed state, safe to read from any thread
+  // while the spline is edited; null unless snapshots are enabled
+  std::shared_ptr<const SplineSnapshot> getSnapshot() const;
+  void setSnapshots(bool enabled);
+  inline bool getSnapshots() const { return snapshotsEnabled; }
 
   // Selection
   const int getSelectedIdx() const { return selectedIdx; };
@@ -73,7 +168,36 @@ public:
   // Setter
   void setSelectedIdx(int idx) { selectedIdx = idx; }
   void setLoop(bool loop);
-  void setPoints(std::vector<Eigen::Vector3f>& points);
-  void setAntribute(std::vector<Eigen::Vector3f>& points, bool loop);
+  void setLengthTolerance(float tolerance);
+  // The points are shared with the caller's copy until one of them changes
+  void setPoints(const ControlPoints& points);
+  // Copy memory-mapped control points into memory, the spline is unchanged
+  void unmapPoints() { m_points.unmap(); }
+  void setAntribute(const ControlPoints& points, bool loop);
   void setSelectedPoint(Eigen::Vector3f& p);
-};
\ No newline at end of file
+};
+
+// Scoped edit of a spline, the changes are committed in one rebuild when it
+// goes out of scope unless it was committed or rolled back before
+class SplineEdit
+{
+private:
+  Spline* spline;
+  bool open;
+
+public:
+  explicit SplineEdit(Spline* spline) : spline(spline), open(true) { spline->beginEdit(); }
+  ~SplineEdit() { commit(); }
+  bool commit() {
+    if (!open) return false;
+    open = false;
+    return spline->commitEdit();
+  }
+  void rollback() {
+    if (!open) return;
+    open = false;
+    spline->rollbackEdit();
+  }
+  SplineEdit(const SplineEdit&) = delete;
+  SplineEdit& operator=(const SplineEdit&) = delete;
+};
@@ -0,0 +1,157 @@
+#include "SplineCursor.h"
+
+/******************************************************************************
+Move the cursor to the curve containing arc-length s
+
+Entry:
+  spline - spline to look up
+  s      - arc-length in (0, arcLength)
+
+Exit:
+  curve, start and end describe the curve with start <= s < end
+******************************************************************************/
+void SplineCursor::locate(Spline* spline, float s)
+{
+  const ArcLengthIndex& index = spline->getLengthIndex();
+  int n = index.size();
+
+  if (this->spline == spline && epoch == spline->getEpoch() && curve >= 0 && curve < n) {
+    for (int step = 0; step < MAX_WALK; step++) {
+      if (s < start && curve > 0) {
+        curve--;
+        end = start;
+        start -= index.length(curve);
+      }
+      else if (s >= end && curve < n - 1) {
+        start = end;
+        curve++;
+        end += index.length(curve);
+      }
+      else {
+        return;
+      }
+    }
+    if (s >= start && s < end)
+      return;
+  }
+
+  // Too far or the spline changed, search from the root
+  double rest;
+  curve = index.find(s, rest);
+  start = s - rest;
+  end = start + index.length(curve);
+  this->spline = spline;
+  epoch = spline->getEpoch();
+}
+
+/******************************************************************************
+Move the cursor to the curve of a snapshot containing arc-length s
+
+Epochs are unique across splines, so a snapshot shares the cached curve with
+the spline state it was taken from
+******************************************************************************/
+void SplineCursor::locate(const SplineSnapshot& snapshot, float s)
+{
+  int n = snapshot.getNumCurves();
+
+  if (epoch == snapshot.getEpoch() && curve >= 0 && curve < n) {
+    for (int step = 0; step < MAX_WALK; step++) {
+      if (s < start && curve > 0) {
+        curve--;
+        end = start;
+        start = snapshot.prefix(curve);
+      }
+      else if (s >= end && curve < n - 1) {
+        start = end;
+        curve++;
+        end = snapshot.prefix(curve + 1);
+      }
+      else {
+        return;
+      }
+    }
+    if (s >= start && s < end)
+      return;
+  }
+
+  // Too far or another snapshot, search from the root
+  curve = snapshot.parameterizeUnitSpeed(s).first;
+  start = snapshot.prefix(curve);
+  end = snapshot.prefix(curve + 1);
+  spline = nullptr;
+  epoch = snapshot.getEpoch();
+}
+
+/******************************************************************************
+Reparameterize t to (i, u), the same mapping as Spline::parameterize and
+Spline::parameterizeUnitSpeed
+******************************************************************************/
+std::pair<int, float> SplineCursor::parameterize(Spline* spline, float t, bool flagUS)
+{
+  if (!flagUS)
+    return spline->parameterize(t);
+
+  int n = spline->getNumCurves();
+  if (t <= 0.0f) return { 0, 0.0f };
+  if (t >= spline->getArcLength()) return { n - 1, 1.0f };
+
+  locate(spline, t);
+  return { curve, spline->getU(curve, (float)(t - start)) };
+}
+
+/******************************************************************************
+Evaluate the spline at t
+
+Entry:
+  spline - spline to evaluate
+  t      - parameter, arc-length if flagUS
+  flagUS - unit speed parameterization
+
+Exit:
+  returns position, tangent and second derivative from one evaluation
+******************************************************************************/
+CurvePoint SplineCursor::evaluate(Spline* spline, float t, bool flagUS)
+{
+  if (spline->getNumCurves() == 0) {
+    CurvePoint ret;
+    ret.position.setZero();
+    ret.first.setZero();
+    ret.second.setZero();
+    return ret;
+  }
+  std::pair<int, float> u = parameterize(spline, t, flagUS);
+  return spline->getCurves()[u.first].evaluate(u.second);
+}
+
+/******************************************************************************
+Reparameterize t to (i, u) on a snapshot, the same mapping as
+SplineSnapshot::parameterize and SplineSnapshot::parameterizeUnitSpeed
+******************************************************************************/
+std::pair<int, float> SplineCursor::parameterize(const SplineSnapshot& snapshot, float t, bool flagUS)
+{
+  if (!flagUS)
+    return snapshot.parameterize(t);
+
+  int n = snapshot.getNumCurves();
+  if (t <= 0.0f) return { 0, 0.0f };
+  if (t >= snapshot.getArcLength()) return { n - 1, 1.0f };
+
+  locate(snapshot, t);
+  return { curve, snapshot.getU(curve, (float)(t - start)) };
+}
+
+/******************************************************************************
+Evaluate a snapshot at t, see evaluate on a spline
+******************************************************************************/
+CurvePoint SplineCursor::evaluate(const SplineSnapshot& snapshot, float t, bool flagUS)
+{
+  if (snapshot.getNumCurves() == 0) {
+    CurvePoint ret;
+    ret.position.setZero();
+    ret.first.setZero();
+    ret.second.setZero();
+    return ret;
+  }
+  std::pair<int, float> u = parameterize(snapshot, t, flagUS);
+  return snapshot.getCurve(u.first).evaluate(u.second);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Spline.h"
+
+// Remembers the curve of the last lookup on a spline or one of its snapshots,
+// so lookups that move a little each frame walk to the neighbouring curve
+// instead of searching
+class SplineCursor
+{
+private:
+  const Spline* spline;   // Spline of the cached curve, null for a snapshot
+  unsigned int epoch;     // Spline epoch of the cached curve
+  int curve;              // Curve of the last lookup
+  double start, end;      // Arc-length range of the curve
+
+  void locate(Spline* spline, float s);
+  void locate(const SplineSnapshot& snapshot, float s);
+
+public:
+  // Lookups further away than this many curves search the length index
+  static const int MAX_WALK = 8;
+
+  SplineCursor() : spline(nullptr), epoch(0), curve(-1), start(0.0), end(0.0) {}
+
+  // Position, first and second derivative at t, arc-length if flagUS
+  CurvePoint evaluate(Spline* spline, float t, bool flagUS);
+  std::pair<int, float> parameterize(Spline* spline, float t, bool flagUS);
+  // The same on a snapshot, for readers that must not see an edit half done
+  CurvePoint evaluate(const SplineSnapshot& snapshot, float t, bool flagUS);
+  std::pair<int, float> parameterize(const SplineSnapshot& snapshot, float t, bool flagUS);
+  void reset() { spline = nullptr; curve = -1; }
+};
@@ -0,0 +1,133 @@
+#include "SplineSnapshot.h"
+#include <algorithm>
+#include <cmath>
+
+// Chunks of count elements holding an index of changes
+static std::vector<char> changedChunks(const SnapshotChanges& changes, int count)
+{
+  int chunks = (count + SplineSnapshot::CHUNK - 1) / SplineSnapshot::CHUNK;
+  std::vector<char> changed(chunks, 0);
+  for (int c = std::min(changes.from / SplineSnapshot::CHUNK, chunks); c < chunks; c++)
+    changed[c] = 1;
+  for (int i : changes.single)
+    if (i >= 0 && i / SplineSnapshot::CHUNK < chunks)
+      changed[i / SplineSnapshot::CHUNK] = 1;
+  return changed;
+}
+
+/******************************************************************************
+Create the snapshot of a spline after an edit
+
+Entry:
+  points, curves - the current control points and curves
+  tables         - arc-length tables of the curved curves
+  tableStart     - curved curves before each curve
+  loop, epoch    - the current state of the spline
+  previous       - the last snapshot, or null
+  pointChanges   - points changed since previous
+  curveChanges   - curves changed since previous
+
+Exit:
+  returns the new snapshot; chunks without changes and of unchanged size
+  are shared with previous, the others are copied
+******************************************************************************/
+std::shared_ptr<const SplineSnapshot> SplineSnapshot::create(
+    const ControlPoints& points, const std::vector<Curve>& curves,
+    const std::vector<ArcLengthTable>& tables, const std::vector<int>& tableStart,
+    bool loop, unsigned int epoch, const SplineSnapshot* previous,
+    const SnapshotChanges& pointChanges, const SnapshotChanges& curveChanges)
+{
+  std::shared_ptr<SplineSnapshot> ret = std::make_shared<SplineSnapshot>();
+  ret->numPoints = (int)points.size();
+  ret->numCurves = (int)curves.size();
+  ret->loop = loop;
+  ret->epoch = epoch;
+
+  std::vector<char> changed = changedChunks(pointChanges, ret->numPoints);
+  ret->pointChunks.resize(changed.size());
+  for (int c = 0; c < (int)changed.size(); c++) {
+    int begin = c * CHUNK, end = std::min(begin + CHUNK, ret->numPoints);
+    if (!changed[c] && previous && c < (int)previous->pointChunks.size() &&
+        (int)previous->pointChunks[c]->size() == end - begin)
+      ret->pointChunks[c] = previous->pointChunks[c];
+    else
+      ret->pointChunks[c] = std::make_shared<const PointChunk>(points.begin() + begin, points.begin() + end);
+  }
+
+  changed = changedChunks(curveChanges, ret->numCurves);
+  ret->curveChunks.resize(changed.size());
+  ret->offsets.assign(changed.size() + 1, 0.0);
+  for (int c = 0; c < (int)changed.size(); c++) {
+    int begin = c * CHUNK, end = std::min(begin + CHUNK, ret->numCurves);
+    if (!changed[c] && previous && c < (int)previous->curveChunks.size() &&
+        (int)previous->curveChunks[c]->curves.size() == end - begin) {
+      ret->curveChunks[c] = previous->curveChunks[c];
+    }
+    else {
+      std::shared_ptr<CurveChunk> chunk = std::make_shared<CurveChunk>();
+      chunk->curves.assign(curves.begin() + begin, curves.begin() + end);
+      // The tables of a run of curves are contiguous
+      int firstTable = tableStart[begin];
+      int lastTable = (end < ret->numCurves) ? tableStart[end] : (int)tables.size();
+      chunk->tables.assign(tables.begin() + firstTable, tables.begin() + lastTable);
+      chunk->tableStart.resize(end - begin);
+      for (int i = begin; i < end; i++)
+        chunk->tableStart[i - begin] = tableStart[i] - firstTable;
+      chunk->prefix.resize(end - begin + 1);
+      chunk->prefix[0] = 0.0;
+      for (int i = 0; i < end - begin; i++)
+        chunk->prefix[i + 1] = chunk->prefix[i] + chunk->curves[i].getLength();
+      ret->curveChunks[c] = chunk;
+    }
+    ret->offsets[c + 1] = ret->offsets[c] + ret->curveChunks[c]->prefix.back();
+  }
+  ret->arcLength = (float)ret->offsets.back();
+  return ret;
+}
+
+/******************************************************************************
+Reparameterize t to (i, u)
+******************************************************************************/
+std::pair<int, float> SplineSnapshot::parameterize(float t) const
+{
+  t = std::fmod(t, (float)numCurves);
+  int idx = (int)std::floor(t);
+  return { idx, t - (float)idx };
+}
+
+/******************************************************************************
+Reparameterize the arc-length s to (i, u), searching the chunk offsets first
+and then the prefix of the chunk
+******************************************************************************/
+std::pair<int, float> SplineSnapshot::parameterizeUnitSpeed(float s) const
+{
+  if (s <= 0.0f) return { 0, 0.0f };
+  if (s >= arcLength) return { numCurves - 1, 1.0f };
+
+  int c = (int)(std::upper_bound(offsets.begin() + 1, offsets.end() - 1, (double)s) - offsets.begin()) - 1;
+  const CurveChunk& chunk = *curveChunks[c];
+  double rest = s - offsets[c];
+  int j = (int)(std::upper_bound(chunk.prefix.begin() + 1, chunk.prefix.end() - 1, rest) - chunk.prefix.begin()) - 1;
+  return { c * CHUNK + j, getU(c * CHUNK + j, (float)(rest - chunk.prefix[j])) };
+}
+
+Eigen::Vector3f SplineSnapshot::getPosition(float t, bool flagUS) const
+{
+  if (numCurves == 0) return Eigen::Vector3f::Zero();
+  std::pair<int, float> u = flagUS ? parameterizeUnitSpeed(t) : parameterize(t);
+  return getCurve(u.first).getPosition(u.second);
+}
+
+Eigen::Vector3f SplineSnapshot::getTangent(float t, bool flagUS) const
+{
+  if (numCurves == 0) return Eigen::Vector3f::Zero();
+  std::pair<int, float> u = flagUS ? parameterizeUnitSpeed(t) : parameterize(t);
+  return getCurve(u.first).getTangent(u.second);
+}
+
+double SplineSnapshot::getCurvature(float t, bool flagUS) const
+{
+  if (numCurves == 0) return 0.0;
+  std::pair<int, float> u = flagUS ? parameterizeUnitSpeed(t) : parameterize(t);
+  return getCurve(u.first).getCurvature(u.second);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ControlPoints.h"
+#include "Curve.h"
+#include <Eigen/Dense>
+#include <climits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Indices changed since the last snapshot: everything from `from` on plus
+// single elements
+struct SnapshotChanges
+{
+  int from = INT_MAX;
+  std::vector<int> single;
+
+  void markAll() { from = 0; }
+  void markFrom(int i) { from = (i < from) ? i : from; }
+  void mark(int i) { single.push_back(i); }
+  void clear() { from = INT_MAX; single.clear(); }
+};
+
+// Immutable version of a spline for readers on other threads. Points and
+// curves are kept in shared chunks, a new snapshot copies only the chunks an
+// edit touched and shares the others with the previous one.
+class SplineSnapshot
+{
+public:
+  static const int CHUNK = 1024;  // Points or curves per chunk
+
+private:
+  struct CurveChunk {
+    std::vector<Curve> curves;
+    std::vector<double> prefix;   // Length of the curves before each one, size() + 1
+    std::vector<ArcLengthTable> tables;   // Tables of the curved ones, in order
+    std::vector<int> tableStart;          // Curved curves of the chunk before each one
+  };
+  typedef std::vector<Eigen::Vector3f> PointChunk;
+
+  std::vector<std::shared_ptr<const PointChunk>> pointChunks;
+  std::vector<std::shared_ptr<const CurveChunk>> curveChunks;
+  std::vector<double> offsets;    // Length of the chunks before each one, size() + 1
+  int numPoints = 0;
+  int numCurves = 0;
+  float arcLength = 0.0f;
+  bool loop = false;
+  unsigned int epoch = 0;
+
+public:
+  // Snapshot of the given state, sharing the unchanged chunks of previous
+  static std::shared_ptr<const SplineSnapshot> create(
+      const ControlPoints& points, const std::vector<Curve>& curves,
+      const std::vector<ArcLengthTable>& tables, const std::vector<int>& tableStart,
+      bool loop, unsigned int epoch, const SplineSnapshot* previous,
+      const SnapshotChanges& pointChanges, const SnapshotChanges& curveChanges);
+
+  // Same parameterizations as Spline
+  std::pair<int, float> parameterize(float t) const;
+  std::pair<int, float> parameterizeUnitSpeed(float s) const;
+  Eigen::Vector3f getPosition(float t, bool flagUS) const;
+  Eigen::Vector3f getTangent(float t, bool flagUS) const;
+  double getCurvature(float t, bool flagUS) const;
+
+  inline const Curve& getCurve(int i) const {
+    return curveChunks[i / CHUNK]->curves[i % CHUNK];
+  }
+  // u on curve i at arc-length s from its start
+  inline float getU(int i, float s) const {
+    const CurveChunk& chunk = *curveChunks[i / CHUNK];
+    const Curve& curve = chunk.curves[i % CHUNK];
+    return curve.getU(s, curve.getDegree() > 1 ? &chunk.tables[chunk.tableStart[i % CHUNK]] : nullptr);
+  }
+  inline const Eigen::Vector3f& getPoint(int i) const {
+    return (*pointChunks[i / CHUNK])[i % CHUNK];
+  }
+  // Length of the first i curves
+  inline double prefix(int i) const {
+    return (i >= numCurves) ? offsets.back()
+                            : offsets[i / CHUNK] + curveChunks[i / CHUNK]->prefix[i % CHUNK];
+  }
+  inline int getNumPoints() const { return numPoints; }
+  inline int getNumCurves() const { return numCurves; }
+  inline float getArcLength() const { return arcLength; }
+  inline bool getLoop() const { return loop; }
+  inline unsigned int getEpoch() const { return epoch; }
+};
@@ -0,0 +1,55 @@
+#include "TrackCache.h"
+#include "CurveProcessor.h"
+
+TrackCache::TrackCache(float segLen)
+  : segLen(segLen), adaptive(true), chordal(2e-4f), angle(0.05f), epoch(0), valid(false),
+    resamples(0) {}
+
+/******************************************************************************
+Get the samples of a spline
+
+Entry:
+  spline - the spline to sample
+
+Exit:
+  returns the cached samples; epochs are unique across splines, so a
+  replaced spline is resampled as well as an edited one
+******************************************************************************/
+const TrackSamples& TrackCache::get(Spline* spline)
+{
+  if (!valid || spline->getEpoch() != epoch) {
+    if (adaptive)
+      CurveProcessor::sampleTrackAdaptive(spline, chordal, angle, samples);
+    else
+      CurveProcessor::sampleTrack(spline, segLen, samples);
+    epoch = spline->getEpoch();
+    valid = true;
+    resamples++;
+  }
+  return samples;
+}
+
+void TrackCache::setSampleLength(float length)
+{
+  if (length != segLen) {
+    segLen = length;
+    valid = false;
+  }
+}
+
+void TrackCache::setAdaptive(bool flag)
+{
+  if (flag != adaptive) {
+    adaptive = flag;
+    valid = false;
+  }
+}
+
+void TrackCache::setTolerances(float chordal, float angle)
+{
+  if (chordal != this->chordal || angle != this->angle) {
+    this->chordal = chordal;
+    this->angle = angle;
+    valid = false;
+  }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Spline.h"
+#include "TrackSamples.h"
+
+// Samples of the current track shared by the tube, its colours and analysis.
+// They are taken again only when the spline epoch or the sample length changes.
+class TrackCache
+{
+private:
+  TrackSamples samples;
+  float segLen;           // Length between samples
+  bool adaptive;          // Sample by tolerances instead of segLen
+  float chordal;          // Largest distance from a chord between samples
+  float angle;            // Largest turn between samples, in radians
+  unsigned int epoch;     // Epoch of the sampled spline
+  bool valid;
+  int resamples;          // Number of times the track was sampled
+
+public:
+  explicit TrackCache(float segLen = 0.01f);
+
+  // Samples of the spline, resampled if it changed since the last call
+  const TrackSamples& get(Spline* spline);
+  void invalidate() { valid = false; }
+
+  inline float getSampleLength() const { return segLen; }
+  void setSampleLength(float length);
+  inline bool getAdaptive() const { return adaptive; }
+  void setAdaptive(bool flag);
+  inline float getChordalTolerance() const { return chordal; }
+  inline float getAngleTolerance() const { return angle; }
+  void setTolerances(float chordal, float angle);
+  inline int getResamples() const { return resamples; }
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <vector>
+
+// Samples of a whole track as structure of arrays, one entry per sample in
+// every array. Kept between samplings so the buffers are reused.
+struct TrackSamples
+{
+  std::vector<Eigen::Vector3f> positions;
+  std::vector<Eigen::Vector3f> tangents;    // C'(u), not normalized
+  std::vector<Eigen::Vector3f> normals;     // Unit normals propagated along the track
+  std::vector<float> curvatures;
+  std::vector<Eigen::Vector3f> seconds;     // Scratch C''(u) per sample
+  std::vector<float> parameters;            // Scratch u per sample
+  std::vector<int> offsets;                 // First sample of every curve, and the total
+
+  inline int size() const { return (int)positions.size(); }
+};
@@ -7,6 +7,7 @@ Model::Model():
 	spline(std::make_unique<Polyline>()),
 	useUntiSpeed(false), useBishop(false)
 { 
+	spline->setSnapshots(true);
 	carts.emplace_back(0.0f);
 	carts.emplace_back(0.15f);
 	carts.emplace_back(0.30f);
@@ -29,4 +30,6 @@ void Model::setPolyhedron(Polyhedron *poly) {
 void Model::setSpline(Spline* curve)
 {
 	spline.reset(curve);
+	// The carts read the track through its snapshots
+	spline->setSnapshots(true);
 }
\ No newline at end of file
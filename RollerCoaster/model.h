@@ -4,6 +4,7 @@
 #include "mesh/meshrenderer.h"
 #include "curves/Spline.h"
 #include "curves/CurveRenderer.h"
+#include "curves/TrackCache.h"
 #include "curves/Cart.h"
 
 class Model {
@@ -19,6 +20,9 @@ public:
   MeshRenderer *getMeshRenderer() { return meshRenderer.get(); }
   Spline* getSpline() const { return spline.get(); }
   CurveRenderer* getCurveRenderer() { return curveRenderer.get(); }
+  // Samples of the current spline, resampled only after it changed
+  const TrackSamples& getTrackSamples() { return trackCache.get(spline.get()); }
+  TrackCache& getTrackCache() { return trackCache; }
   bool getUseUntiSpeed() const { return useUntiSpeed; }
   void setUseUntiSpeed(bool flag) { useUntiSpeed = flag; }
   bool getUseBishop() const { return useBishop; }
@@ -31,6 +35,7 @@ private:
   std::unique_ptr<Spline> spline;
   std::unique_ptr<CurveRenderer> curveRenderer;
   std::vector<Cart> carts;
+  TrackCache trackCache;
 
   bool useUntiSpeed;
   bool useBishop;
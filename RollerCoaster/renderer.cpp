@@ -67,12 +67,12 @@ void Renderer::render() {
   const Eigen::Vector3f &camPos = cam->position();
   // Spline Points
   Spline *spline = scene->getModel()->getSpline();
-  if (scene->getShowPoints()) {
-    std::vector<Eigen::Vector3f> &points = spline->getPoints();
+  std::shared_ptr<const SplineSnapshot> snapshot = spline->getSnapshot();
+  if (scene->getShowPoints() && snapshot) {
     vertexHelper->use(projection, view, camPos);
-    for (int i = 0; i < points.size(); i++) {
+    for (int i = 0; i < snapshot->getNumPoints(); i++) {
       bool flag = (spline->getSelectedIdx() == i);
-      vertexHelper->draw(points[i], flag);
+      vertexHelper->draw(snapshot->getPoint(i), flag);
     }
   }
   // Spline Pipe
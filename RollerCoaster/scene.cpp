@@ -36,10 +36,14 @@ void Scene::update() {
 
 void Scene::updateCarts()
 {
+    // One snapshot for all carts, so they ride the same version of the track
+    std::shared_ptr<const SplineSnapshot> snapshot = model->getSpline()->getSnapshot();
+    if (!snapshot)
+        return;
     std::vector<Cart>& carts = model->getCarts();
     for (int i = 0; i < (int)carts.size(); i++)
     {
-        carts[i].update(model->getSpline(), timeElapsed,
+        carts[i].update(*snapshot, timeElapsed,
             model->getUseUntiSpeed(),
             model->getUseBishop());
     }
@@ -47,7 +51,7 @@ void Scene::updateCarts()
 
 void Scene::updateCurveRenderer()
 {
-    model->getCurveRenderer()->createVBO(model->getSpline(), showCurvatures);
+    model->getCurveRenderer()->createVBO(model->getSpline(), model->getTrackSamples(), showCurvatures);
 }
 
 void Scene::setupCamera() {
@@ -74,7 +78,7 @@ void Scene::resize(int width, int height) {
 void Scene::setShowCurvatures(bool flag)
 {
     showCurvatures = flag;
-    model->getCurveRenderer()->setColor(model->getSpline(), showCurvatures);
+    model->getCurveRenderer()->setColor(model->getTrackSamples(), showCurvatures);
 }
 
 void Scene::toggleAnimation() {
@@ -0,0 +1,169 @@
+#include "Tests.h"
+#include "../RollerCoaster/curves/ArcLengthIndex.h"
+#include "../RollerCoaster/curves/Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Prefix sums summed one by one, what the index has to agree with
+static std::vector<double> prefixes(const std::vector<float> &lengths) {
+  std::vector<double> ret(lengths.size() + 1, 0.0);
+  for (size_t i = 0; i < lengths.size(); i++)
+    ret[i + 1] = ret[i] + lengths[i];
+  return ret;
+}
+
+// Last curve starting at or before s, clamped to the curves
+static int findLinear(const std::vector<double> &prefix, double s) {
+  int n = (int)prefix.size() - 1;
+  int i = (int)(std::upper_bound(prefix.begin(), prefix.end() - 1, s) - prefix.begin()) - 1;
+  return std::min(std::max(i, 0), n - 1);
+}
+
+// Prefixes, total and the curves found at the midpoints of the curves and
+// at random arc-lengths, against the one by one sums
+static bool sameAsLinear(const ArcLengthIndex &index, const std::vector<float> &lengths,
+                         std::mt19937 &rng, double tolerance) {
+  std::vector<double> prefix = prefixes(lengths);
+  int n = (int)lengths.size();
+  if (index.size() != n || std::abs(index.total() - prefix[n]) > tolerance)
+    return false;
+  for (int i = 0; i <= n; i++)
+    if (std::abs(index.prefix(i) - prefix[i]) > tolerance)
+      return false;
+  std::vector<double> queries;
+  for (int i = 0; i < n; i++)
+    if (lengths[i] > 4.0 * tolerance)
+      queries.push_back(0.5 * (prefix[i] + prefix[i + 1]));
+  std::uniform_real_distribution<double> any(0.0, prefix[n]);
+  for (int q = 0; q < 1000; q++) {
+    double s = any(rng);
+    int i = findLinear(prefix, s);
+    // Too close to a boundary to tell the curves apart after rounding
+    if (s - prefix[i] > tolerance && prefix[i + 1] - s > tolerance)
+      queries.push_back(s);
+  }
+  for (double s : queries) {
+    double rest;
+    int i = index.find(s, rest);
+    if (i != findLinear(prefix, s) || std::abs(rest - (s - prefix[i])) > tolerance)
+      return false;
+  }
+  return true;
+}
+
+/******************************************************************************
+Arc-lengths exactly at the start of a curve, before the start and past the
+end of the spline
+
+The lengths are multiples of 1 / 4 so every prefix is exact; runs of curves
+without length make several curves start at the same arc-length, find picks
+the last of them
+******************************************************************************/
+static void testBoundaries() {
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> quarters(0, 8);
+  for (int n : {1, 2, 3, 7, 8, 9, 100, 1025}) {
+    std::vector<float> lengths;
+    for (int i = 0; i < n; i++)
+      lengths.push_back(i % 5 == 1 ? 0.0f : 0.25f * (float)quarters(rng));
+    ArcLengthIndex index;
+    for (float length : lengths)
+      index.push_back(length);
+    std::vector<double> prefix = prefixes(lengths);
+
+    for (int i = 0; i <= n; i++) {
+      double rest;
+      int found = index.find(prefix[i], rest);
+      int expected = findLinear(prefix, prefix[i]);
+      CHECK(found == expected && rest == prefix[i] - prefix[found],
+            "%d curves: arc-length %g found curve %d rest %g, expected %d", n, prefix[i], found,
+            rest, expected);
+    }
+    double rest;
+    CHECK(index.find(-1.0, rest) == 0 && rest == -1.0, "%d curves: before the start", n);
+    int last = index.find(prefix[n] + 1.0, rest);
+    CHECK(last == n - 1 && rest == prefix[n] + 1.0 - prefix[n - 1],
+          "%d curves: past the end found curve %d rest %g", n, last, rest);
+  }
+  ArcLengthIndex empty;
+  double rest;
+  CHECK(empty.find(1.0, rest) == 0 && rest == 1.0 && empty.total() == 0.0, "empty index");
+}
+
+/******************************************************************************
+Changing single lengths, shrinking and growing again, against prefix sums
+recomputed after every change
+******************************************************************************/
+static void testUpdate() {
+  const int n = 1000;
+  std::mt19937 rng(6);
+  std::uniform_real_distribution<float> length(0.0f, 2.0f);
+  std::uniform_int_distribution<int> curve(0, n - 1);
+  std::vector<float> lengths;
+  ArcLengthIndex index;
+  for (int i = 0; i < n; i++) {
+    lengths.push_back(length(rng));
+    index.push_back(lengths.back());
+  }
+
+  for (int round = 0; round < 20; round++) {
+    for (int change = 0; change < 50; change++) {
+      int i = curve(rng);
+      lengths[i] = (change % 7 == 0) ? 0.0f : length(rng);
+      index.update(i, lengths[i]);
+    }
+    CHECK(sameAsLinear(index, lengths, rng, 1e-9), "round %d: updated index differs", round);
+  }
+
+  lengths.resize(377);
+  index.resize(377);
+  CHECK(sameAsLinear(index, lengths, rng, 1e-9), "index differs after resize");
+  for (int i = 0; i < 100; i++) {
+    lengths.push_back(length(rng));
+    index.push_back(lengths.back());
+  }
+  index.update(376, 3.0f);
+  lengths[376] = 3.0f;
+  CHECK(sameAsLinear(index, lengths, rng, 1e-9), "index differs after growing again");
+}
+
+/******************************************************************************
+append against push_back of the same lengths, on several threads
+
+The appends start at sizes that are not powers of two, so nodes of the new
+curves reach back into the curves already in the index
+******************************************************************************/
+static void testAppend() {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> length(0.0f, 2.0f);
+  Parallel::setThreadCount(4);
+  for (int first : {0, 1, 1000, 77777}) {
+    for (int n : {1, 5, 40000, 300000}) {
+      std::vector<float> lengths(first + n);
+      for (float &value : lengths)
+        value = length(rng);
+      ArcLengthIndex single, appended;
+      for (float value : lengths)
+        single.push_back(value);
+      for (int i = 0; i < first; i++)
+        appended.push_back(lengths[i]);
+      appended.append(lengths.data() + first, n);
+
+      bool same = appended.size() == single.size();
+      double tolerance = 1e-12 * single.total() + 1e-12;
+      for (int i = 0; same && i <= single.size(); i++)
+        same = std::abs(appended.prefix(i) - single.prefix(i)) <= tolerance;
+      CHECK(same, "append of %d after %d differs from push_back", n, first);
+      CHECK(sameAsLinear(appended, lengths, rng, 1e-6), "append of %d after %d: find differs", n,
+            first);
+    }
+  }
+  Parallel::setThreadCount(0);
+}
+
+void testArcLengthIndex() {
+  testBoundaries();
+  testUpdate();
+  testAppend();
+}
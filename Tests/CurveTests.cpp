@@ -0,0 +1,123 @@
+#include "Tests.h"
+#include "../RollerCoaster/curves/BSpline.h"
+#include "../RollerCoaster/curves/CatmullRom.h"
+#include "../RollerCoaster/curves/Polyline.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+std::vector<Track> makeTracks() {
+  std::vector<Track> tracks;
+  tracks.push_back({"square",
+                    {{-0.5f, 0.0f, -0.5f}, {-0.5f, 0.0f, 0.5f}, {0.5f, 0.0f, 0.5f}, {0.5f, 0.0f, -0.5f}},
+                    true});
+
+  std::vector<Eigen::Vector3f> loops;
+  float x = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++, x += 2.0f)
+      loops.emplace_back(x, 0.0f, 0.0f);
+    for (int j = 0; j < 12; j++) {
+      float a = (float)j / 12.0f * 6.2831853f;
+      loops.emplace_back(x + std::sin(a), 1.0f - std::cos(a), 0.05f * (float)j);
+    }
+    x += 2.0f;
+  }
+  tracks.push_back({"loops", loops, false});
+
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+  std::vector<Eigen::Vector3f> wiggle;
+  Eigen::Vector3f p(0.0f, 0.0f, 0.0f);
+  for (int i = 0; i < 200; i++) {
+    p += Eigen::Vector3f(offset(rng), 0.3f * offset(rng), offset(rng));
+    wiggle.push_back(p);
+  }
+  tracks.push_back({"wiggle", wiggle, false});
+  return tracks;
+}
+
+/******************************************************************************
+The speed along a curve parameterized by arc length through getU stays 1
+
+Every curve is sampled at uniformly spaced s; the speed is ||C'(u)|| du/ds
+with du/ds from a central difference of getU. The median and the 99th
+percentile are bounded everywhere. The worst case is only bounded on pieces
+between knots of the arc-length table where the speed stays within a factor
+of two: where it drops sharply, u(s) bends more than a cubic between two
+knots can follow. The arc-length at the knots is checked against
+Simpson's rule on a fine grid
+******************************************************************************/
+static void testUnitSpeed(Spline &spline, const char *name, const char *type) {
+  const int STEPS = 256;
+  const int N = ArcLengthTable::SIZE;
+  const float MAX_MEDIAN = 1e-4f;
+  const float MAX_P99 = 1e-2f;
+  const float MAX_DEVIATION = 0.1f;
+  const float MAX_KNOT_ERROR = 1e-4f;
+  const float SLOW = 0.5f;
+  std::vector<float> deviations;
+  float worst = 0.0f, knotError = 0.0f;
+  for (int curve = 0; curve < spline.getNumCurves(); curve++) {
+    const Curve &c = spline.getCurves()[curve];
+    const ArcLengthTable *table = spline.getArcTable(curve);
+    auto getU = [&](float s) { return spline.getU(curve, s); };
+    float length = c.getLength();
+    if (length <= 0.0f || !table)
+      continue;
+
+    // Knots against Simpson's rule on a fine grid, relative to the length
+    const int FINE = 64;
+    double reference = 0.0;
+    for (int k = 0; k < N; k++) {
+      for (int j = 0; j < FINE; j++) {
+        float u0 = (float)(k * FINE + j) / (float)(N * FINE);
+        float u1 = (float)(k * FINE + j + 1) / (float)(N * FINE);
+        reference += (u1 - u0) / 6.0 *
+             (c.getTangent(u0).norm() + 4.0 * c.getTangent(0.5f * (u0 + u1)).norm() +
+              c.getTangent(u1).norm());
+      }
+      knotError = std::max(knotError, (float)std::abs(table->s[k + 1] - reference) / length);
+    }
+
+    float h = 1e-3f * length;
+    for (int i = 1; i < STEPS; i++) {
+      float s = length * (float)i / (float)STEPS;
+      float dudS = (getU(s + h) - getU(s - h)) / (2.0f * h);
+      float deviation = std::abs(c.getTangent(getU(s)).norm() * dudS - 1.0f);
+      deviations.push_back(deviation);
+
+      // Slowest and fastest point of the knot piece around s
+      int k = std::min((int)(getU(s) * N), N - 1);
+      float slowest = INFINITY, fastest = 0.0f;
+      for (int j = 0; j <= 8; j++) {
+        float speed = c.getTangent((k + j / 8.0f) / N).norm();
+        slowest = std::min(slowest, speed);
+        fastest = std::max(fastest, speed);
+      }
+      if (slowest >= SLOW * fastest)
+        worst = std::max(worst, deviation);
+    }
+  }
+  std::sort(deviations.begin(), deviations.end());
+  float median = deviations[deviations.size() / 2];
+  float p99 = deviations[deviations.size() * 99 / 100];
+  std::printf("  unit speed %-6s %-10s median %.1e  p99 %.1e  max %.1e  knots %.1e\n", name, type,
+              median, p99, worst, knotError);
+  CHECK(median <= MAX_MEDIAN, "%s %s: median speed deviation %g", name, type, median);
+  CHECK(p99 <= MAX_P99, "%s %s: 99th percentile speed deviation %g", name, type, p99);
+  CHECK(worst <= MAX_DEVIATION, "%s %s: speed deviates from 1 by %g", name, type, worst);
+  CHECK(knotError <= MAX_KNOT_ERROR, "%s %s: arc-length table off by %g of the length", name,
+        type, knotError);
+}
+
+void testCurves() {
+  for (const Track &track : makeTracks()) {
+    BSpline bspline;
+    bspline.setAntribute(track.points, track.loop);
+    testUnitSpeed(bspline, track.name, "BSpline");
+    CatmullRom catmullRom;
+    catmullRom.setAntribute(track.points, track.loop);
+    testUnitSpeed(catmullRom, track.name, "CatmullRom");
+  }
+}
@@ -0,0 +1,193 @@
+#include "Tests.h"
+#include "../RollerCoaster/curves/BSpline.h"
+#include "../RollerCoaster/curves/CatmullRom.h"
+#include "../RollerCoaster/curves/Parallel.h"
+#include "../RollerCoaster/curves/Polyline.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+
+static std::unique_ptr<Spline> makeSpline(int type) {
+  if (type == 0)
+    return std::make_unique<Polyline>();
+  if (type == 1)
+    return std::make_unique<BSpline>();
+  return std::make_unique<CatmullRom>();
+}
+
+static const char *const TYPE_NAMES[] = {"Polyline", "BSpline", "CatmullRom"};
+
+/******************************************************************************
+Every index of forRange is visited once, chunks are at least grain long and
+a range started inside a chunk runs inline; exclusiveScan matches a serial
+sum in double
+******************************************************************************/
+static void testForRange() {
+  for (int threads : {1, 2, 4, 7}) {
+    Parallel::setThreadCount(threads);
+    for (int n : {0, 1, 63, 64, 1000, 100000}) {
+      for (int grain : {1, 64, 4096}) {
+        std::vector<std::atomic<int>> visits(n);
+        std::atomic<int> shortChunks(0), chunks(0);
+        Parallel::forRange(n, grain, [&](int begin, int end) {
+          chunks++;
+          if (end - begin < grain && end - begin < n)
+            shortChunks++;
+          for (int i = begin; i < end; i++)
+            visits[i]++;
+        });
+        bool once = true;
+        for (int i = 0; i < n; i++)
+          once = once && visits[i] == 1;
+        CHECK(once, "%d threads, n %d, grain %d: indices not visited once", threads, n, grain);
+        CHECK(shortChunks == 0 && chunks <= threads,
+              "%d threads, n %d, grain %d: %d chunks, %d below the grain", threads, n, grain,
+              chunks.load(), shortChunks.load());
+      }
+    }
+
+    // Nested ranges run on the thread of the outer chunk
+    std::vector<std::atomic<int>> visits(64 * 64);
+    Parallel::forRange(64, 1, [&](int begin, int end) {
+      for (int i = begin; i < end; i++)
+        Parallel::forRange(64, 1, [&](int first, int last) {
+          for (int j = first; j < last; j++)
+            visits[i * 64 + j]++;
+        });
+    });
+    bool once = true;
+    for (std::atomic<int> &visit : visits)
+      once = once && visit == 1;
+    CHECK(once, "%d threads: nested ranges not visited once", threads);
+
+    std::mt19937 rng(threads);
+    std::uniform_real_distribution<float> value(0.0f, 1.0f);
+    for (int n : {0, 1, 1000, 300000}) {
+      std::vector<float> in(n);
+      for (float &v : in)
+        v = value(rng);
+      std::vector<double> out(n + 1);
+      Parallel::exclusiveScan(in.data(), n, out.data());
+      double sum = 0.0, worst = 0.0;
+      for (int i = 0; i <= n; i++) {
+        worst = std::max(worst, std::abs(out[i] - sum));
+        if (i < n)
+          sum += in[i];
+      }
+      CHECK(worst <= 1e-12 * std::max(sum, 1.0), "%d threads, n %d: scan off by %g", threads, n,
+            worst);
+    }
+  }
+  Parallel::setThreadCount(0);
+}
+
+/******************************************************************************
+Compare two splines built from the same points
+
+Exit:
+  returns what differs first, null if the curves, arc-length tables and bounds
+  are the same and the arc-lengths agree up to the order of the sums
+******************************************************************************/
+static const char *differs(Spline &a, Spline &b) {
+  int n = a.getNumCurves();
+  if (n != b.getNumCurves())
+    return "number of curves";
+  for (int i = 0; i < n; i++) {
+    const Curve &c = a.getCurves()[i];
+    const Curve &d = b.getCurves()[i];
+    if (c.getMP() != d.getMP() || c.getDegree() != d.getDegree() || c.getLength() != d.getLength())
+      return "curve";
+    const ArcLengthTable *table = a.getArcTable(i);
+    const ArcLengthTable *other = b.getArcTable(i);
+    if ((table == nullptr) != (other == nullptr) ||
+        (table && std::memcmp(table, other, sizeof(ArcLengthTable)) != 0))
+      return "arc-length table";
+    if (a.getCurveBounds(i).min() != b.getCurveBounds(i).min() ||
+        a.getCurveBounds(i).max() != b.getCurveBounds(i).max())
+      return "curve bounds";
+  }
+  double tolerance = 1e-9 * std::max(1.0, b.getLengthIndex().total());
+  for (int i = 0; i <= n; i += std::max(1, n / 1000))
+    if (std::abs(a.getLengthIndex().prefix(i) - b.getLengthIndex().prefix(i)) > tolerance)
+      return "length index";
+  if (std::abs(a.getArcLength() - b.getArcLength()) > 1e-6f * b.getArcLength())
+    return "arc-length";
+  return nullptr;
+}
+
+/******************************************************************************
+Long runs of segments built on several threads against a serial build
+
+The serial open spline grows one point at a time, so every rebuild appends a
+few segments on the calling thread; closed splines always rebuild as a whole
+and are built with one thread instead. The parallel builds use several
+thread counts, and the open ones also rebuild a long tail after a point near
+the start moves
+******************************************************************************/
+static void testParallelBuild() {
+  const int POINTS = 20000;
+  std::mt19937 rng(17);
+  std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+  std::vector<Eigen::Vector3f> points;
+  Eigen::Vector3f p(0.0f, 0.0f, 0.0f);
+  for (int i = 0; i < POINTS; i++) {
+    p += Eigen::Vector3f(offset(rng), 0.3f * offset(rng), offset(rng));
+    // Runs of points on a line give straight segments between curved ones
+    if (i >= 2 && i % 50 < 6)
+      p = 2.0f * points.back() - points[points.size() - 2];
+    points.push_back(p);
+  }
+
+  for (int type = 0; type < 3; type++) {
+    for (bool loop : {false, true}) {
+      std::unique_ptr<Spline> serial = makeSpline(type);
+      if (loop) {
+        Parallel::setThreadCount(1);
+        serial->setAntribute(points, true);
+      }
+      else {
+        for (Eigen::Vector3f &q : points)
+          serial->addPoint(q);
+      }
+
+      for (int threads : {2, 4, 7}) {
+        Parallel::setThreadCount(threads);
+        std::unique_ptr<Spline> parallel = makeSpline(type);
+        parallel->setAntribute(points, loop);
+        const char *difference = differs(*parallel, *serial);
+        CHECK(!difference, "%s %s, %d threads: %s differs from the serial build",
+              TYPE_NAMES[type], loop ? "closed" : "open", threads, difference);
+        // Only counts the last rebuild, a whole one on both sides when closed
+        CHECK(!loop || parallel->getLengthEvaluations() == serial->getLengthEvaluations(),
+              "%s closed, %d threads: %d speed evaluations, %d in the serial build",
+              TYPE_NAMES[type], threads, parallel->getLengthEvaluations(),
+              serial->getLengthEvaluations());
+      }
+      Parallel::setThreadCount(0);
+    }
+  }
+
+  // A point near the start of an open spline rebuilds the long tail after it
+  for (int type = 0; type < 3; type++) {
+    std::unique_ptr<Spline> parallel = makeSpline(type);
+    parallel->setAntribute(points, false);
+    parallel->setSelectedIdx(10);
+    parallel->removePoint();
+    std::vector<Eigen::Vector3f> rest = points;
+    rest.erase(rest.begin() + 10);
+    std::unique_ptr<Spline> serial = makeSpline(type);
+    Parallel::setThreadCount(1);
+    serial->setAntribute(rest, false);
+    Parallel::setThreadCount(0);
+    const char *difference = differs(*parallel, *serial);
+    CHECK(!difference, "%s: %s of the rebuilt tail differs from the serial build",
+          TYPE_NAMES[type], difference);
+  }
+}
+
+void testParallel() {
+  testForRange();
+  testParallelBuild();
+}
@@ -0,0 +1,134 @@
+#include "Tests.h"
+#include "../RollerCoaster/curves/BSpline.h"
+#include "../RollerCoaster/curves/CatmullRom.h"
+#include "../RollerCoaster/curves/Polyline.h"
+#include <cmath>
+#include <limits>
+#include <random>
+
+// Squared distance to the closest point of any curve, trying every curve
+static float closestBruteForce(Spline &spline, const Eigen::Vector3f &p) {
+  float best = std::numeric_limits<float>::infinity();
+  for (const Curve &curve : spline.getCurves()) {
+    float u;
+    best = std::min(best, curve.closestPoint(p, u));
+  }
+  return best;
+}
+
+/******************************************************************************
+Spline::closestPoint against the closest point of every curve
+
+Entry:
+  spline  - the spline to project on
+  queries - points near and far from the track
+
+Exit:
+  returns what is wrong with the first failing query, null if the distances
+  match and the returned point lies on the returned curve at the returned
+  arc-length
+
+The hierarchy only tries curves that can be closer than the best so far, so
+it never beats the brute force; it may only miss it by rounding of the bounds
+******************************************************************************/
+static const char *differsFromBruteForce(Spline &spline,
+                                         const std::vector<Eigen::Vector3f> &queries) {
+  for (const Eigen::Vector3f &p : queries) {
+    SplineProjection projection = spline.closestPoint(p);
+    if (projection.curve < 0 || projection.curve >= spline.getNumCurves())
+      return "curve";
+    float best = closestBruteForce(spline, p);
+    float distance2 = projection.distance * projection.distance;
+    if (distance2 < best * (1.0f - 1e-5f) || distance2 > best * (1.0f + 1e-5f) + 1e-10f)
+      return "distance";
+    const Curve &curve = spline.getCurves()[projection.curve];
+    if ((curve.getPosition(projection.u) - projection.position).norm() > 1e-5f ||
+        std::abs((projection.position - p).norm() - projection.distance) >
+            1e-5f * (1.0f + projection.distance))
+      return "position";
+    double s = spline.getLengthIndex().prefix(projection.curve) + curve.getS(projection.u);
+    if (std::abs(projection.s - s) > 1e-5 * (1.0 + s))
+      return "arc-length";
+  }
+  return nullptr;
+}
+
+/******************************************************************************
+Queries after edits that refit the hierarchy and after ones that rebuild it
+
+Moving single points only changes the bounds of a few curves, so the boxes
+above them are refit; adding and removing points and closing the track
+rebuild it. The track spans many leaves, some queries lie on control points
+and some far outside the track
+******************************************************************************/
+static void testQueries(Spline &spline, const char *type) {
+  const int POINTS = 2000;
+  const int QUERIES = 200;
+  const int ROUNDS = 12;
+
+  std::mt19937 rng(19);
+  std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+  std::uniform_int_distribution<int> index(0, POINTS - 1);
+  std::vector<Eigen::Vector3f> points;
+  Eigen::Vector3f p(0.0f, 0.0f, 0.0f);
+  for (int i = 0; i < POINTS; i++) {
+    p += Eigen::Vector3f(offset(rng), 0.3f * offset(rng), offset(rng));
+    points.push_back(p);
+  }
+  spline.setAntribute(points, false);
+
+  for (int round = 0; round < ROUNDS; round++) {
+    if (round % 4 == 1) {
+      for (int k = 0; k < 20; k++) {
+        spline.setSelectedIdx(index(rng));
+        Eigen::Vector3f moved = spline.getSelectedPoint() +
+                                3.0f * Eigen::Vector3f(offset(rng), offset(rng), offset(rng));
+        spline.setSelectedPoint(moved);
+      }
+    }
+    else if (round % 4 == 2) {
+      spline.setSelectedIdx(index(rng) / 2);
+      spline.removePoint();
+      Eigen::Vector3f end = spline.getPoints()[spline.getPoints().size() - 1];
+      Eigen::Vector3f added = end + Eigen::Vector3f(offset(rng), 0.0f, offset(rng));
+      spline.addPoint(added);
+    }
+    else if (round % 4 == 3) {
+      spline.setLoop(!spline.getLoop());
+    }
+
+    std::vector<Eigen::Vector3f> queries;
+    int n = (int)spline.getPoints().size();
+    for (int q = 0; q < QUERIES; q++) {
+      Eigen::Vector3f near = spline.getPoints()[q * (n - 1) / (QUERIES - 1)];
+      if (q % 10 == 0)
+        queries.push_back(near);
+      else if (q % 10 == 1)
+        queries.push_back(near + 1000.0f * Eigen::Vector3f(offset(rng), offset(rng), offset(rng)));
+      else
+        queries.push_back(near + 5.0f * Eigen::Vector3f(offset(rng), offset(rng), offset(rng)));
+    }
+    const char *difference = differsFromBruteForce(spline, queries);
+    CHECK(!difference, "%s round %d: closest point %s differs from the brute force", type, round,
+          difference);
+  }
+
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float inf = std::numeric_limits<float>::infinity();
+  for (const Eigen::Vector3f &q :
+       {Eigen::Vector3f(nan, 0.0f, 0.0f), Eigen::Vector3f(0.0f, inf, 0.0f)})
+    CHECK(spline.closestPoint(q).curve == -1, "%s: a point that is not finite found curve %d",
+          type, spline.closestPoint(q).curve);
+}
+
+void testSegmentBVH() {
+  Polyline polyline;
+  testQueries(polyline, "Polyline");
+  BSpline bspline;
+  testQueries(bspline, "BSpline");
+  CatmullRom catmullRom;
+  testQueries(catmullRom, "CatmullRom");
+
+  BSpline empty;
+  CHECK(empty.closestPoint(Eigen::Vector3f::Zero()).curve == -1, "empty spline found a curve");
+}
@@ -0,0 +1,117 @@
+#include "Tests.h"
+#include "../RollerCoaster/curves/BSpline.h"
+#include "../RollerCoaster/curves/CatmullRom.h"
+#include "../RollerCoaster/curves/SplineCursor.h"
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+
+/******************************************************************************
+Read snapshots on other threads while commitEdit runs
+
+Every edit moves all control points by one more step, alternating between
+replacing the points and moving them one by one in a SplineEdit. A snapshot
+has to be one whole version: all its points moved by the same number of
+steps, and the positions a cursor reads from it, as the carts do, those of a
+spline built from the unmoved points moved by as many steps. The track spans
+several chunks of the snapshot
+******************************************************************************/
+static void testConcurrentReads(Spline &spline, Spline &reference, const char *type, bool loop) {
+  const int POINTS = 3000;
+  const int EDITS = 40;
+  const int READERS = 2;
+  const int SAMPLES = 64;
+  const float MAX_DISTANCE = 1e-3f;
+  const Eigen::Vector3f step(0.25f, 0.0f, -0.125f);
+
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+  std::vector<Eigen::Vector3f> base;
+  Eigen::Vector3f p(0.0f, 0.0f, 0.0f);
+  for (int i = 0; i < POINTS; i++) {
+    p += Eigen::Vector3f(offset(rng), 0.3f * offset(rng), offset(rng));
+    base.push_back(p);
+  }
+  auto moved = [&](int k) {
+    std::vector<Eigen::Vector3f> points;
+    for (const Eigen::Vector3f &q : base)
+      points.push_back(q + (float)k * step);
+    return points;
+  };
+
+  reference.setAntribute(base, loop);
+  std::vector<float> s(SAMPLES);
+  std::vector<Eigen::Vector3f> expected(SAMPLES);
+  for (int j = 0; j < SAMPLES; j++) {
+    s[j] = reference.getArcLength() * ((float)j + 0.5f) / (float)SAMPLES;
+    expected[j] = reference.getPosition(s[j], true);
+  }
+
+  spline.setAntribute(base, loop);
+  spline.setSnapshots(true);
+  std::atomic<bool> done(false);
+  std::atomic<int> reads(0), torn(0), moving(0), backwards(0), farthest(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < READERS; r++) {
+    readers.emplace_back([&]() {
+      SplineCursor cursor;
+      unsigned int last = 0;
+      // One more pass after the last edit reads its snapshot too
+      for (bool more = true; more;) {
+        more = !done.load();
+        std::shared_ptr<const SplineSnapshot> snapshot = spline.getSnapshot();
+        if (snapshot->getEpoch() < last)
+          backwards++;
+        last = snapshot->getEpoch();
+
+        int k = (int)std::lround((snapshot->getPoint(0) - base[0]).x() / step.x());
+        bool whole = snapshot->getNumPoints() == POINTS;
+        for (int i = 0; whole && i < POINTS; i++)
+          whole = snapshot->getPoint(i) == base[i] + (float)k * step;
+        if (!whole)
+          torn++;
+        for (int j = 0; j < SAMPLES; j++) {
+          Eigen::Vector3f position = cursor.evaluate(*snapshot, s[j], true).position;
+          if ((position - (expected[j] + (float)k * step)).norm() > MAX_DISTANCE)
+            moving++;
+        }
+        int seen = farthest.load();
+        while (k > seen && !farthest.compare_exchange_weak(seen, k)) {
+        }
+        reads++;
+      }
+    });
+  }
+
+  for (int k = 1; k <= EDITS; k++) {
+    std::vector<Eigen::Vector3f> points = moved(k);
+    if (k % 2) {
+      spline.setAntribute(points, loop);
+      continue;
+    }
+    SplineEdit edit(&spline);
+    for (int i = 0; i < POINTS; i++) {
+      spline.setSelectedIdx(i);
+      spline.setSelectedPoint(points[i]);
+    }
+  }
+  done = true;
+  for (std::thread &reader : readers)
+    reader.join();
+
+  std::printf("  snapshots %-10s %d reads, last edit read %d\n", type, reads.load(),
+              farthest.load());
+  CHECK(torn == 0, "%s: %d snapshots mix points of different edits", type, torn.load());
+  CHECK(moving == 0, "%s: %d positions off the moved reference", type, moving.load());
+  CHECK(backwards == 0, "%s: epoch went back %d times", type, backwards.load());
+  CHECK(farthest == EDITS, "%s: the last edit read was %d of %d", type, farthest.load(), EDITS);
+}
+
+void testSnapshots() {
+  BSpline bspline, bsplineReference;
+  testConcurrentReads(bspline, bsplineReference, "BSpline", false);
+  CatmullRom catmullRom, catmullRomReference;
+  testConcurrentReads(catmullRom, catmullRomReference, "CatmullRom", true);
+}
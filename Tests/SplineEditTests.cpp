@@ -0,0 +1,310 @@
+#include "Tests.h"
+#include "../RollerCoaster/curves/BSpline.h"
+#include "../RollerCoaster/curves/CatmullRom.h"
+#include "../RollerCoaster/curves/Polyline.h"
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+
+static std::unique_ptr<Spline> makeSpline(Spline::Type type) {
+  switch (type) {
+  case Spline::Type::BSpline:
+    return std::make_unique<BSpline>();
+  case Spline::Type::CatmullRom:
+    return std::make_unique<CatmullRom>();
+  default:
+    return std::make_unique<Polyline>();
+  }
+}
+
+static const char *typeName(Spline::Type type) {
+  switch (type) {
+  case Spline::Type::BSpline:
+    return "BSpline";
+  case Spline::Type::CatmullRom:
+    return "CatmullRom";
+  default:
+    return "Polyline";
+  }
+}
+
+/******************************************************************************
+Compare a spline with one of the same type built from scratch from its points
+
+Exit:
+  returns what differs first, null if the curves, their arc-length tables and
+  bounds are the same and the arc-lengths agree up to rounding
+******************************************************************************/
+static const char *differsFromFull(Spline &spline) {
+  std::unique_ptr<Spline> full = makeSpline(spline.getType());
+  full->setAntribute(spline.getPoints(), spline.getLoop());
+
+  int n = spline.getNumCurves();
+  if (n != full->getNumCurves())
+    return "number of curves";
+  for (int i = 0; i < n; i++) {
+    const Curve &c = spline.getCurves()[i];
+    const Curve &f = full->getCurves()[i];
+    if (c.getMP() != f.getMP() || c.getDegree() != f.getDegree())
+      return "curve coefficients";
+    if (c.getLength() != f.getLength())
+      return "curve length";
+    const ArcLengthTable *table = spline.getArcTable(i);
+    const ArcLengthTable *fullTable = full->getArcTable(i);
+    if ((table == nullptr) != (fullTable == nullptr) ||
+        (table && std::memcmp(table, fullTable, sizeof(ArcLengthTable)) != 0))
+      return "arc-length table";
+    if (spline.getCurveBounds(i).min() != full->getCurveBounds(i).min() ||
+        spline.getCurveBounds(i).max() != full->getCurveBounds(i).max())
+      return "curve bounds";
+  }
+  double tolerance = 1e-6 * std::max(1.0f, full->getArcLength());
+  if (std::abs(spline.getArcLength() - full->getArcLength()) > tolerance)
+    return "arc-length";
+  for (int i = 0; i <= n; i++)
+    if (std::abs(spline.getLengthIndex().prefix(i) - full->getLengthIndex().prefix(i)) > tolerance)
+      return "length index";
+  return nullptr;
+}
+
+/******************************************************************************
+Random edits rebuilt incrementally against a full rebuild after each of them
+
+Points move, including the first and last ones whose curves wrap around on
+closed splines, are appended and removed, and several edits are batched in a
+SplineEdit, some around an inner edit that is rolled back. Coordinates are
+multiples of 1 / 4, so four points put evenly on a line are exact and make
+the curves between them straight; a curved segment that turns straight drops
+its arc-length table and gets one back later. The tracks start below four points so that the cubic splines go from
+no curves to some and back
+******************************************************************************/
+static void testIncremental(Spline::Type type, bool loop) {
+  const int EDITS = 300;
+  std::mt19937 rng(loop ? 21 : 12);
+  std::uniform_int_distribution<int> quarter(-8, 8);
+  std::uniform_int_distribution<int> operation(0, 10);
+  auto randomPoint = [&]() {
+    return Eigen::Vector3f(0.25f * (float)quarter(rng), 0.25f * (float)quarter(rng),
+                           0.25f * (float)quarter(rng));
+  };
+  auto pick = [&](int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); };
+
+  std::unique_ptr<Spline> spline = makeSpline(type);
+  std::vector<Eigen::Vector3f> start = {randomPoint(), randomPoint()};
+  spline->setAntribute(start, loop);
+
+  for (int edit = 0; edit < EDITS; edit++) {
+    int n = spline->getPoints().size();
+    int op = operation(rng);
+    const char *name;
+    if (n < 3 || (op == 0 && n < 40)) {
+      name = "append";
+      Eigen::Vector3f p = randomPoint();
+      spline->addPoint(p);
+    }
+    else if (op == 1 && n > 3) {
+      name = "remove";
+      spline->setSelectedIdx(pick(n));
+      spline->removePoint();
+    }
+    else if (op == 2) {
+      name = "straighten";
+      // Four points evenly spaced on a line make the curves between them straight
+      SplineEdit batch(spline.get());
+      int k = pick(n);
+      Eigen::Vector3f p = spline->getPoints()[k], step = randomPoint();
+      for (int j = 1; j < 4 && j < n; j++) {
+        Eigen::Vector3f q = p + (float)j * step;
+        spline->setSelectedIdx((k + j) % n);
+        spline->setSelectedPoint(q);
+      }
+    }
+    else if (op == 3) {
+      name = "batch";
+      SplineEdit batch(spline.get());
+      for (int j = 0; j < 3; j++) {
+        Eigen::Vector3f p = randomPoint();
+        spline->setSelectedIdx(pick(n));
+        spline->setSelectedPoint(p);
+      }
+      Eigen::Vector3f p = randomPoint();
+      spline->addPoint(p);
+    }
+    else if (op == 10) {
+      name = "inner rollback";
+      // The segments the rolled back edit marked stay marked for the outer one
+      SplineEdit batch(spline.get());
+      Eigen::Vector3f p = randomPoint();
+      spline->setSelectedIdx(pick(n));
+      spline->setSelectedPoint(p);
+      {
+        SplineEdit inner(spline.get());
+        spline->addPoint(p);
+        spline->setSelectedIdx(pick(n));
+        spline->removePoint();
+        p = randomPoint();
+        spline->setSelectedIdx(pick(n));
+        spline->setSelectedPoint(p);
+        inner.rollback();
+      }
+      p = randomPoint();
+      spline->setSelectedIdx(pick(n));
+      spline->setSelectedPoint(p);
+    }
+    else {
+      name = "move";
+      // The ends are moved more often, their curves wrap around on loops
+      int k = (op == 4) ? 0 : (op == 5) ? n - 1 : pick(n);
+      Eigen::Vector3f p = randomPoint();
+      spline->setSelectedIdx(k);
+      spline->setSelectedPoint(p);
+    }
+    const char *difference = differsFromFull(*spline);
+    CHECK(!difference, "%s %s: %s at edit %d (%s, %d points) differs from a full rebuild",
+          typeName(type), loop ? "closed" : "open", difference, edit, name,
+          spline->getPoints().size());
+    if (difference)
+      return;
+  }
+}
+
+static bool samePoints(const ControlPoints &a, const ControlPoints &b) {
+  if (a.size() != b.size())
+    return false;
+  for (int i = 0; i < a.size(); i++)
+    if (a[i] != b[i])
+      return false;
+  return true;
+}
+
+// Same curves, tables and length as before an edit that was rolled back
+static bool sameCurves(Spline &spline, const std::vector<Curve> &curves, float arcLength) {
+  if (spline.getNumCurves() != (int)curves.size() || spline.getArcLength() != arcLength)
+    return false;
+  for (int i = 0; i < (int)curves.size(); i++)
+    if (spline.getCurves()[i].getMP() != curves[i].getMP() ||
+        spline.getCurves()[i].getLength() != curves[i].getLength())
+      return false;
+  return true;
+}
+
+/******************************************************************************
+Commit and rollback of SplineEdit, nested ones included
+
+A committed edit rebuilds once when the outermost edit ends, to the same
+curves as a full rebuild. A rolled back edit restores the points, the loop
+flag and the tolerance; the outermost one rebuilds nothing and publishes no
+snapshot, an inner one leaves the changes of the outer edit in place
+******************************************************************************/
+static void testScopedEdits(Spline::Type type, const std::vector<Eigen::Vector3f> &points) {
+  const char *name = typeName(type);
+  std::unique_ptr<Spline> spline = makeSpline(type);
+  spline->setAntribute(points, true);
+  spline->setSnapshots(true);
+  Eigen::Vector3f up(0.0f, 1.0f, 0.0f);
+
+  // Commit: the curves stay as they are until the edit ends
+  unsigned int epoch = spline->getEpoch();
+  int numCurves = spline->getNumCurves();
+  {
+    SplineEdit edit(spline.get());
+    for (int k : {0, 5, 6, 20}) {
+      Eigen::Vector3f p = spline->getPoints()[k] + up;
+      spline->setSelectedIdx(k);
+      spline->setSelectedPoint(p);
+    }
+    Eigen::Vector3f p = spline->getPoints().back() + up;
+    spline->addPoint(p);
+    spline->setSelectedIdx(10);
+    spline->removePoint();
+    {
+      SplineEdit inner(spline.get());
+      spline->setLoop(false);
+      CHECK(!inner.commit(), "%s: inner commit rebuilt", name);
+    }
+    CHECK(spline->getEpoch() == epoch && spline->getNumCurves() == numCurves,
+          "%s: rebuilt before the outermost edit ended", name);
+    CHECK(edit.commit(), "%s: commit reports no change", name);
+    CHECK(!edit.commit(), "%s: second commit reports a change", name);
+  }
+  CHECK(spline->getEpoch() != epoch, "%s: commit kept the epoch", name);
+  const char *difference = differsFromFull(*spline);
+  CHECK(!difference, "%s: %s differs from a full rebuild after commit", name, difference);
+  {
+    SplineEdit edit(spline.get());
+    epoch = spline->getEpoch();
+    CHECK(!edit.commit() && spline->getEpoch() == epoch, "%s: empty edit rebuilt", name);
+  }
+
+  // Rollback of the outermost edit: everything as before, nothing rebuilt
+  ControlPoints before = spline->getPoints();
+  std::vector<Curve> curves = spline->getCurves();
+  float arcLength = spline->getArcLength();
+  float tolerance = spline->getLengthTolerance();
+  std::shared_ptr<const SplineSnapshot> snapshot = spline->getSnapshot();
+  epoch = spline->getEpoch();
+  {
+    SplineEdit edit(spline.get());
+    Eigen::Vector3f p = spline->getPoints()[3] + up;
+    spline->setSelectedIdx(3);
+    spline->setSelectedPoint(p);
+    spline->setSelectedIdx(0);
+    spline->removePoint();
+    spline->addPoint(p);
+    spline->setLoop(true);
+    spline->setLengthTolerance(1e-2f);
+    spline->setAntribute(points, false);
+    spline->setSelectedIdx(spline->getPoints().size() - 1);
+    spline->removePoint();
+    edit.rollback();
+  }
+  CHECK(samePoints(spline->getPoints(), before), "%s: rollback changed the points", name);
+  CHECK(!spline->getLoop() && spline->getLengthTolerance() == tolerance,
+        "%s: rollback changed the loop flag or the tolerance", name);
+  CHECK(spline->getEpoch() == epoch && sameCurves(*spline, curves, arcLength),
+        "%s: rollback rebuilt the curves", name);
+  CHECK(spline->getSnapshot() == snapshot, "%s: rollback published a snapshot", name);
+  CHECK(!spline->isEditing(), "%s: rollback left the edit open", name);
+
+  // Rollback of an inner edit: the outer edit's changes are committed
+  std::vector<Eigen::Vector3f> expected(before.begin(), before.end());
+  {
+    SplineEdit edit(spline.get());
+    Eigen::Vector3f p = expected[2] + up;
+    expected[2] = p;
+    spline->setSelectedIdx(2);
+    spline->setSelectedPoint(p);
+    {
+      SplineEdit inner(spline.get());
+      Eigen::Vector3f q = spline->getPoints()[7] + up;
+      spline->setSelectedIdx(7);
+      spline->setSelectedPoint(q);
+      // Segments of the appended point are gone after the rollback
+      spline->addPoint(q);
+      q += up;
+      spline->setSelectedIdx(spline->getPoints().size() - 1);
+      spline->setSelectedPoint(q);
+      inner.rollback();
+    }
+  }
+  CHECK(samePoints(spline->getPoints(), ControlPoints(expected)) && !spline->getLoop(),
+        "%s: inner rollback undid the wrong changes", name);
+  difference = differsFromFull(*spline);
+  CHECK(!difference, "%s: %s differs from a full rebuild after an inner rollback", name,
+        difference);
+  std::shared_ptr<const SplineSnapshot> last = spline->getSnapshot();
+  CHECK(last->getEpoch() == spline->getEpoch() && last->getNumPoints() == (int)expected.size(),
+        "%s: snapshot not published after an inner rollback", name);
+}
+
+void testSplineEdits() {
+  for (Spline::Type type : {Spline::Type::Polyline, Spline::Type::BSpline, Spline::Type::CatmullRom})
+    for (bool loop : {false, true})
+      testIncremental(type, loop);
+
+  std::vector<Eigen::Vector3f> points = makeTracks()[2].points;
+  points.resize(30);
+  for (Spline::Type type : {Spline::Type::Polyline, Spline::Type::BSpline, Spline::Type::CatmullRom})
+    testScopedEdits(type, points);
+}
@@ -0,0 +1,21 @@
+// Checks of the curve core that do not need a window.
+//
+// Usage: Tests
+// Prints every failed check and returns the number of failures.
+#include "Tests.h"
+
+int failures = 0;
+
+int main() {
+  testCurves();
+  testArcLengthIndex();
+  testSplineEdits();
+  testParallel();
+  testSegmentBVH();
+  testControlPoints();
+  testSnapshots();
+
+  if (failures == 0)
+    std::printf("All checks passed\n");
+  return failures;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstdio>
+#include <vector>
+
+// Number of failed checks of the whole run
+extern int failures;
+
+#define CHECK(condition, ...)                                                                     \
+  do {                                                                                            \
+    if (!(condition)) {                                                                           \
+      std::printf("FAILED %s:%d: ", __FILE__, __LINE__);                                         \
+      std::printf(__VA_ARGS__);                                                                   \
+      std::printf("\n");                                                                          \
+      failures++;                                                                                 \
+    }                                                                                             \
+  } while (0)
+
+// Control points of the tracks the checks run on
+struct Track {
+  const char *name;
+  std::vector<Eigen::Vector3f> points;
+  bool loop;
+};
+
+// A closed square, an open track with loops and an open random walk
+std::vector<Track> makeTracks();
+
+void testCurves();
+void testArcLengthIndex();
+void testControlPoints();
+void testSplineEdits();
+void testParallel();
+void testSegmentBVH();
+void testSnapshots();